@@ -0,0 +1,382 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "bench.h"
+#include <ircmsg/simd.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// Where the result of each pass ends up, so that it has to be
+// computed.
+static volatile size_t bench_sink;
+
+static double
+bench_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+// The name of the corpus in `path`: its file name without the
+// extension.
+static const char *
+corpus_name(const char *path, char *name, size_t name_cap)
+{
+	const char *base = strrchr(path, '/');
+	base = base != NULL ? base + 1 : path;
+
+	size_t len = strcspn(base, ".");
+	if (len >= name_cap) len = name_cap - 1;
+	memcpy(name, base, len);
+	name[len] = '\0';
+	return name;
+}
+
+bool
+bench_corpus_load(struct bench_corpus *corpus, const char *path)
+{
+	static char name[256];
+
+	memset(corpus, 0, sizeof(*corpus));
+	corpus->name = corpus_name(path, name, sizeof(name));
+
+	FILE *file = fopen(path, "rb");
+	if (file == NULL) return false;
+
+	if (fseek(file, 0, SEEK_END) != 0) goto fail;
+	long file_size = ftell(file);
+	if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) goto fail;
+
+	// Every byte of the file at most turns into a CRLF.
+	size_t cap = (size_t) file_size * 2 + 2;
+	uint8_t *text = malloc((size_t) file_size + 1);
+	corpus->data = malloc(cap);
+	corpus->ends = malloc(((size_t) file_size + 1) * sizeof(*corpus->ends));
+	if (text == NULL || corpus->data == NULL || corpus->ends == NULL) {
+		free(text);
+		goto fail;
+	}
+	if (fread(text, 1, (size_t) file_size, file) != (size_t) file_size) {
+		free(text);
+		goto fail;
+	}
+	fclose(file);
+
+	// Lines may end in LF or CRLF. Empty ones are left out.
+	const uint8_t *iter = text;
+	const uint8_t *const end = text + file_size;
+	while (iter < end) {
+		const uint8_t *line_end = memchr(iter, '\n', end - iter);
+		if (line_end == NULL) line_end = end;
+
+		size_t len = line_end - iter;
+		if (len > 0 && iter[len - 1] == '\r') --len;
+		if (len > 0) {
+			memcpy(corpus->data + corpus->size, iter, len);
+			corpus->size += len;
+			corpus->data[corpus->size++] = '\r';
+			corpus->data[corpus->size++] = '\n';
+			corpus->ends[corpus->count++] = corpus->size;
+		}
+
+		iter = line_end + 1;
+	}
+	free(text);
+
+	return corpus->count > 0;
+
+fail:
+	fclose(file);
+	bench_corpus_free(corpus);
+	return false;
+}
+
+void
+bench_corpus_free(struct bench_corpus *corpus)
+{
+	free(corpus->data);
+	free(corpus->ends);
+	corpus->data = NULL;
+	corpus->ends = NULL;
+	corpus->size = 0;
+	corpus->count = 0;
+}
+
+// Takes apart the message in [buf, buf+len), with room for exactly as
+// many tags and params as it has.
+static bool
+message_load(struct bench_message *message, const uint8_t *buf, size_t len)
+{
+	ircmsg_message_view *view = &message->view;
+	message->buf = buf;
+
+	// The first parse only counts the tags and params.
+	if (ircmsg_parse_to_view(buf, len, view) == 0 &&
+	    view->error != IRCMSG_ERR_PARSER_VIEW_OVERFLOW) {
+		return false;
+	}
+
+	view->tags = malloc((view->tag_count + 1) * sizeof(*view->tags));
+	view->tags_cap = view->tag_count;
+	view->params = malloc((view->param_count + 1) * sizeof(*view->params));
+	view->params_cap = view->param_count;
+	message->unescaped = malloc((view->tag_count + 1) *
+				    sizeof(*message->unescaped));
+	message->values = malloc(len);
+	if (view->tags == NULL || view->params == NULL ||
+	    message->unescaped == NULL || message->values == NULL ||
+	    ircmsg_parse_to_view(buf, len, view) == 0) {
+		return false;
+	}
+
+	// The serializer wants the tag values unescaped, which never
+	// makes them any longer.
+	size_t values_len = 0;
+	for (size_t tag = 0; tag < view->tag_count; ++tag) {
+		const ircmsg_span *value = &view->tags[tag].value;
+		message->unescaped[tag].offset = values_len;
+		message->unescaped[tag].len = ircmsg_tag_value_unescape_into(
+			buf + value->offset, value->len,
+			message->values + values_len, len - values_len);
+		values_len += message->unescaped[tag].len;
+	}
+
+	return true;
+}
+
+struct bench_message *
+bench_messages_load(const struct bench_corpus *corpus)
+{
+	struct bench_message *messages = calloc(corpus->count, sizeof(*messages));
+	if (messages == NULL) return NULL;
+
+	size_t start = 0;
+	for (size_t i = 0; i < corpus->count; ++i) {
+		if (!message_load(&messages[i], corpus->data + start,
+				  corpus->ends[i] - start)) {
+			bench_messages_free(messages, i + 1);
+			return NULL;
+		}
+		start = corpus->ends[i];
+	}
+
+	return messages;
+}
+
+void
+bench_messages_free(struct bench_message *messages, size_t count)
+{
+	if (messages == NULL) return;
+
+	for (size_t i = 0; i < count; ++i) {
+		free(messages[i].view.tags);
+		free(messages[i].view.params);
+		free(messages[i].unescaped);
+		free(messages[i].values);
+	}
+	free(messages);
+}
+
+static size_t
+message_tag_count(void *user_data)
+{
+	const struct bench_message *message = user_data;
+	return message->view.tag_count;
+}
+
+static void
+message_on_tag(size_t tag_idx,
+	       size_t * const tag_len, const uint8_t **tag,
+	       size_t * const val_len, const uint8_t **val,
+	       void *user_data)
+{
+	const struct bench_message *message = user_data;
+	const ircmsg_span *name = &message->view.tags[tag_idx].name;
+	const ircmsg_span *value = &message->unescaped[tag_idx];
+	*tag_len = name->len;
+	*tag = message->buf + name->offset;
+	*val_len = value->len;
+	*val = value->len != 0 ? message->values + value->offset : NULL;
+}
+
+static bool
+message_on_prefix(size_t * const prefix_len,
+		  const uint8_t **prefix,
+		  void *user_data)
+{
+	const struct bench_message *message = user_data;
+	if (!message->view.has_prefix) return false;
+
+	*prefix_len = message->view.prefix.len;
+	*prefix = message->buf + message->view.prefix.offset;
+	return true;
+}
+
+static void
+message_on_command(size_t * const command_len,
+		   const uint8_t **command,
+		   void *user_data)
+{
+	const struct bench_message *message = user_data;
+	*command_len = message->view.command.len;
+	*command = message->buf + message->view.command.offset;
+}
+
+static size_t
+message_param_count(void *user_data)
+{
+	const struct bench_message *message = user_data;
+	return message->view.param_count;
+}
+
+static void
+message_on_param(size_t param_idx,
+		 size_t * const param_len,
+		 const uint8_t **param,
+		 void *user_data)
+{
+	const struct bench_message *message = user_data;
+	*param_len = message->view.params[param_idx].len;
+	*param = message->buf + message->view.params[param_idx].offset;
+}
+
+const ircmsg_serializer_callbacks bench_serializer_cbs = {
+	.tag_count = message_tag_count,
+	.on_tag = message_on_tag,
+	.on_prefix = message_on_prefix,
+	.on_command = message_on_command,
+	.param_count = message_param_count,
+	.on_param = message_on_param,
+};
+
+static void
+count_event(void *user_data)
+{
+	++*(size_t *) user_data;
+}
+
+static void
+count_tag(const uint8_t *name, size_t name_len,
+	  const uint8_t *esc_value, size_t esc_value_len,
+	  void *user_data)
+{
+	++*(size_t *) user_data;
+}
+
+static void
+count_token(const uint8_t *token, size_t token_len, void *user_data)
+{
+	*(size_t *) user_data += token_len;
+}
+
+static void
+count_error(ircmsg_parser_err_code error, void *user_data)
+{
+	++*(size_t *) user_data;
+}
+
+const ircmsg_parser_callbacks bench_parser_cbs = {
+	.start_message = count_event,
+	.start_tags = count_event,
+	.on_tag = count_tag,
+	.end_tags = count_event,
+	.on_prefix = count_token,
+	.on_command = count_token,
+	.start_params = count_event,
+	.on_param = count_token,
+	.end_params = count_event,
+	.end_message = count_event,
+	.on_error = count_error,
+};
+
+void
+bench_run(const char *benchmark,
+	  const struct bench_corpus *corpus,
+	  size_t (*pass)(const struct bench_corpus *corpus, void *ctx),
+	  void *ctx)
+{
+	// One pass first, so that the corpus is in the cache.
+	bench_sink = pass(corpus, ctx);
+
+	size_t passes = 0;
+	double seconds;
+	double start = bench_now();
+	do {
+		bench_sink = pass(corpus, ctx);
+		++passes;
+		seconds = bench_now() - start;
+	} while (seconds < BENCH_MIN_SECONDS);
+
+	double messages = (double) corpus->count * (double) passes;
+	double bytes = (double) corpus->size * (double) passes;
+	printf("{\"benchmark\": \"%s\", \"corpus\": \"%s\", "
+	       "\"simd\": \"%s\", "
+	       "\"passes\": %zu, \"messages\": %.0f, \"bytes\": %.0f, "
+	       "\"seconds\": %.6f, \"messages_per_sec\": %.0f, "
+	       "\"bytes_per_sec\": %.0f, \"ns_per_message\": %.2f}\n",
+	       benchmark, corpus->name,
+	       ircmsg_simd_level_name(ircmsg_simd_get_level()),
+	       passes, messages, bytes, seconds,
+	       messages / seconds, bytes / seconds,
+	       seconds * 1e9 / messages);
+	fflush(stdout);
+}
+
+int
+bench_main(int argc, char **argv,
+	   const char *benchmark,
+	   bool (*setup)(const struct bench_corpus *corpus, void **ctx),
+	   void (*teardown)(const struct bench_corpus *corpus, void *ctx),
+	   size_t (*pass)(const struct bench_corpus *corpus, void *ctx))
+{
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s CORPUS...\n", argv[0]);
+		return 1;
+	}
+
+	for (int i = 1; i < argc; ++i) {
+		struct bench_corpus corpus;
+		if (!bench_corpus_load(&corpus, argv[i])) {
+			fprintf(stderr, "%s: can't load corpus %s\n",
+				argv[0], argv[i]);
+			return 1;
+		}
+
+		void *ctx = NULL;
+		if (setup != NULL && !setup(&corpus, &ctx)) {
+			fprintf(stderr, "%s: can't set up for corpus %s\n",
+				argv[0], argv[i]);
+			if (teardown != NULL) teardown(&corpus, ctx);
+			bench_corpus_free(&corpus);
+			return 1;
+		}
+
+		bench_run(benchmark, &corpus, pass, ctx);
+
+		if (teardown != NULL) teardown(&corpus, ctx);
+		bench_corpus_free(&corpus);
+	}
+
+	return 0;
+}
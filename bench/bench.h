@@ -0,0 +1,92 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// Shared pieces of the benchmarks: loading a corpus, timing a pass
+// over it and printing the results.
+
+#ifndef __BENCH_H_
+#define __BENCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <ircmsg/parser.h>
+#include <ircmsg/serializer.h>
+
+// How long each benchmark runs over each corpus, at the least.
+#define BENCH_MIN_SECONDS 1.0
+
+// A corpus file, one message per line, with the lines turned into
+// messages ending in CRLF, one after another.
+struct bench_corpus
+{
+	const char *name;
+	uint8_t *data;
+	size_t size;
+	// The offset just past each message in `data`.
+	size_t *ends;
+	size_t count;
+};
+
+bool bench_corpus_load(struct bench_corpus *corpus, const char *path);
+void bench_corpus_free(struct bench_corpus *corpus);
+
+// A message of a corpus taken apart, ready to be serialized again. The
+// tag values in `view` are escaped, as they are in `buf`, and
+// `unescaped` holds where each of them is in `values` once unescaped.
+struct bench_message
+{
+	const uint8_t *buf;
+	ircmsg_message_view view;
+	ircmsg_span *unescaped;
+	uint8_t *values;
+};
+
+// Parses every message of `corpus` into a newly allocated array of
+// `corpus->count` messages. Returns NULL if one of them doesn't parse.
+struct bench_message *bench_messages_load(const struct bench_corpus *corpus);
+void bench_messages_free(struct bench_message *messages, size_t count);
+
+// Parser callbacks that only count what they are given, in the size_t
+// that `user_data` points to.
+extern const ircmsg_parser_callbacks bench_parser_cbs;
+
+// Serializer callbacks for a `struct bench_message`.
+extern const ircmsg_serializer_callbacks bench_serializer_cbs;
+
+// Runs `pass` over and over for at least `BENCH_MIN_SECONDS`, and prints
+// how fast it went as a line of JSON. Each pass covers all the messages
+// of `corpus`. What `pass` returns is only kept so that the work it
+// does can't be optimized away.
+void bench_run(const char *benchmark,
+	       const struct bench_corpus *corpus,
+	       size_t (*pass)(const struct bench_corpus *corpus, void *ctx),
+	       void *ctx);
+
+// Runs `pass` on each corpus named in `argv`, for the `main` of a
+// benchmark. `setup`, if not NULL, is called before each corpus is
+// benchmarked to set up `ctx`, and returns false if it couldn't.
+int bench_main(int argc, char **argv,
+	       const char *benchmark,
+	       bool (*setup)(const struct bench_corpus *corpus, void **ctx),
+	       void (*teardown)(const struct bench_corpus *corpus, void *ctx),
+	       size_t (*pass)(const struct bench_corpus *corpus, void *ctx));
+
+#endif /* bench.h */
@@ -0,0 +1,302 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Jani Juhani Sinervo
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Generates synthetic IRC traffic for the benchmarks, one message per line.
+#
+# Each profile shapes the traffic after something a client actually sees,
+# and the output only depends on the profile, the message count and the
+# seed, so that the same corpus can be generated again on another commit.
+# Every message stays within the limits the parser enforces by default,
+# except in the adversarial profile, which is made to fail.
+#
+# Usage: gen_corpus.py PROFILE OUTPUT [--messages N] [--seed S]
+
+import argparse
+import random
+import string
+import sys
+
+MAX_BODY = 510
+MAX_TAGS = 8189
+
+WORDS = ('the', 'a', 'is', 'that', 'was', 'insane', 'run', 'skip', 'route',
+         'anyone', 'clip', 'it', 'lol', 'gg', 'nice', 'what', 'just', 'happened',
+         'chat', 'so', 'good', 'pb', 'world', 'record', 'pace', 'boss', 'fight',
+         'why', 'not', 'again', 'first', 'time', 'here', 'hello', 'from', 'late',
+         'patch', 'build', 'server', 'lag', 'reset', 'Kappa', 'PogChamp', 'LUL',
+         'monkaS', 'o7', ':)', ':(', 'xD', '<3', 'https://example.com/clip/4f2a')
+EMOTES = ('Kappa', 'PogChamp', 'LUL', 'monkaS')
+
+def sentence(rng, low, high):
+    return ' '.join(rng.choice(WORDS) for _ in range(rng.randint(low, high)))
+
+def nick(rng):
+    first = rng.choice(string.ascii_letters + '[]\\`_^{|}')
+    rest = string.ascii_letters + string.digits + '[]\\`_^{|}-'
+    return first + ''.join(rng.choice(rest) for _ in range(rng.randint(2, 15)))
+
+def host(rng):
+    kind = rng.randrange(4)
+    if kind == 0:
+        return '.'.join(str(rng.randint(1, 254)) for _ in range(4))
+    if kind == 1:
+        return '2001:db8:' + ':'.join(f'{rng.randrange(65536):x}'
+                                      for _ in range(rng.randint(1, 6)))
+    if kind == 2:
+        return f'user/{nick(rng).lower()}'
+    return (f'host-{rng.randint(1, 254)}-{rng.randint(1, 254)}.'
+            f'{rng.choice(("example.com", "example.net", "isp.example"))}')
+
+def mask(rng, who=None):
+    who = who or nick(rng)
+    return f'{who}!~{who[:10].lower()}@{host(rng)}'
+
+def channel(rng):
+    return '#' + rng.choice(('speedruns', 'c-programming', 'linux', 'ircv3',
+                             'music', 'help', 'offtopic', 'gaming'))
+
+def uuid(rng):
+    digits = f'{rng.getrandbits(128):032x}'
+    return '-'.join((digits[:8], digits[8:12], digits[12:16], digits[16:20],
+                     digits[20:]))
+
+def tag_escape(value):
+    return (value.replace('\\', '\\\\').replace(';', '\\:')
+            .replace(' ', '\\s').replace('\r', '\\r').replace('\n', '\\n'))
+
+def tags(pairs):
+    return '@' + ';'.join(f'{k}={tag_escape(v)}' if v else k
+                          for k, v in pairs)
+
+def message(tag_section, body):
+    body = body[:MAX_BODY]
+    if tag_section:
+        return f'{tag_section[:MAX_TAGS + 1]} {body}'
+    return body
+
+def server_time(rng):
+    return (f'2024-{rng.randint(1, 12):02}-{rng.randint(1, 28):02}T'
+            f'{rng.randrange(24):02}:{rng.randrange(60):02}:'
+            f'{rng.randrange(60):02}.{rng.randrange(1000):03}Z')
+
+# Tag-heavy chat, shaped after Twitch, where the tags are most of each
+# message.
+def twitch(rng, state):
+    who = nick(rng).lower()
+    text = sentence(rng, 1, 25)
+    emotes = []
+    offset = 0
+    for word in text.split(' '):
+        if word in EMOTES:
+            emotes.append(f'{rng.randrange(1, 300000)}:{offset}-{offset + len(word) - 1}')
+        offset += len(word) + 1
+    sub = rng.random() < 0.4
+    pairs = [
+        ('badge-info', f'subscriber/{rng.randint(1, 60)}' if sub else ''),
+        ('badges', ','.join(rng.sample(('subscriber/12', 'premium/1',
+                                        'moderator/1', 'vip/1', 'bits/1000',
+                                        'glhf-pledge/1'),
+                                       rng.randint(0, 3)))),
+        ('color', rng.choice(('', '#1E90FF', '#FF4500', '#9ACD32', '#8A2BE2'))),
+        ('display-name', who.capitalize()),
+        ('emotes', '/'.join(emotes)),
+        ('first-msg', rng.choice('0000000001')),
+        ('flags', ''),
+        ('id', uuid(rng)),
+        ('mod', rng.choice('0000000001')),
+        ('returning-chatter', '0'),
+        ('room-id', '71092938'),
+        ('subscriber', '1' if sub else '0'),
+        ('tmi-sent-ts', str(1700000000000 + rng.randrange(10 ** 8))),
+        ('turbo', '0'),
+        ('user-id', str(rng.randrange(10 ** 9))),
+        ('user-type', ''),
+    ]
+    kind = rng.random()
+    if kind < 0.9:
+        return message(tags(pairs), f':{who}!{who}@{who}.tmi.twitch.tv '
+                       f'PRIVMSG #speedruns :{text}')
+    if kind < 0.97:
+        pairs += [('msg-id', 'resub'), ('msg-param-cumulative-months', '14'),
+                  ('system-msg', f'{who} subscribed at Tier 1. They\'ve '
+                   f'subscribed for 14 months!'), ('login', who)]
+        return message(tags(pairs), f':tmi.twitch.tv USERNOTICE #speedruns :{text}')
+    return message(tags([('room-id', '71092938'), ('target-user-id', str(rng.randrange(10 ** 9))),
+                         ('tmi-sent-ts', str(1700000000000 + rng.randrange(10 ** 8)))]),
+                   f':tmi.twitch.tv CLEARCHAT #speedruns :{who}')
+
+# A netsplit and the rejoin after it: long runs of QUITs, then JOINs and
+# the modes given back.
+def netsplit(rng, state):
+    if not state.get('burst'):
+        state['kind'] = rng.choice(('QUIT', 'JOIN', 'MODE'))
+        state['burst'] = rng.randint(20, 400)
+        state['chan'] = channel(rng)
+    state['burst'] -= 1
+    tag_section = tags([('time', server_time(rng))]) if rng.random() < 0.3 else ''
+    if state['kind'] == 'QUIT':
+        return message(tag_section, f':{mask(rng)} QUIT :hub.example.net leaf{rng.randint(1, 9)}.example.net')
+    if state['kind'] == 'JOIN':
+        if rng.random() < 0.5:
+            return message(tag_section, f':{mask(rng)} JOIN {state["chan"]}')
+        who = nick(rng)
+        return message(tag_section, f':{mask(rng, who)} JOIN {state["chan"]} '
+                       f'{rng.choice((who, "*"))} :{sentence(rng, 1, 4)}')
+    count = rng.randint(1, 4)
+    return message(tag_section, f':leaf{rng.randint(1, 9)}.example.net MODE {state["chan"]} '
+                   f'+{"".join(rng.choice("ov") for _ in range(count))} '
+                   + ' '.join(nick(rng) for _ in range(count)))
+
+# CTCP and DCC, with the long lines they tend to come with.
+def ctcp(rng, state):
+    who = mask(rng)
+    target = rng.choice((channel(rng), nick(rng)))
+    kind = rng.random()
+    if kind < 0.5:
+        body = f':{who} PRIVMSG {target} :\x01ACTION {sentence(rng, 5, 80)}'
+        return message('', body[:MAX_BODY - 1] + '\x01')
+    if kind < 0.7:
+        name = '_'.join(rng.choice(WORDS).strip(':()<>/') or 'file'
+                        for _ in range(rng.randint(2, 30)))
+        return message('', f':{who} PRIVMSG {nick(rng)} :\x01DCC SEND "{name}.tar.gz" '
+                       f'{rng.getrandbits(32)} {rng.randint(1024, 65535)} '
+                       f'{rng.randrange(10 ** 10)}\x01')
+    if kind < 0.85:
+        return message('', f':{who} PRIVMSG {nick(rng)} :\x01'
+                       f'{rng.choice(("VERSION", "TIME", "PING 1700000000", "CLIENTINFO"))}\x01')
+    return message('', f':{who} NOTICE {nick(rng)} :\x01VERSION ircmsg-client '
+                   f'{rng.randint(0, 9)}.{rng.randint(0, 99)} on '
+                   f'{sentence(rng, 3, 40)}\x01')
+
+# Replies to NAMES and WHO, which come in bursts of long, many-param lines.
+def numerics(rng, state):
+    me = 'alice'
+    chan = channel(rng)
+    kind = rng.random()
+    if kind < 0.4:
+        body = f':irc.example.net 353 {me} = {chan} :'
+        names = []
+        while len(body) + len(' '.join(names)) < MAX_BODY - 20:
+            names.append(rng.choice(('', '', '', '@', '+')) + nick(rng))
+        return message('', body + ' '.join(names))
+    if kind < 0.8:
+        who = nick(rng)
+        return message('', f':irc.example.net 352 {me} {chan} ~{who[:10].lower()} '
+                       f'{host(rng)} leaf{rng.randint(1, 9)}.example.net {who} '
+                       f'{rng.choice(("H", "G", "H@", "H+", "G*"))} '
+                       f':{rng.randint(0, 5)} {sentence(rng, 1, 4)}')
+    if kind < 0.9:
+        return message('', f':irc.example.net {rng.choice(("366", "315"))} {me} {chan} '
+                       f':End of /{rng.choice(("NAMES", "WHO"))} list.')
+    return message('', f':irc.example.net 005 {me} CHANTYPES=# EXCEPTS INVEX '
+                   'CHANMODES=eIbq,k,flj,CFLMPQScgimnprstuz CHANLIMIT=#:120 '
+                   'PREFIX=(ov)@+ MAXLIST=bqeI:100 MODES=4 NETWORK=Example '
+                   'KNOCK STATUSMSG=@+ CALLERID=g :are supported by this server')
+
+# Valid messages that push the parser into its slowest paths: sections
+# right at the limits, tags that are all escapes, a single huge tag with
+# no ';' to split on, and runs of tiny tokens.
+def limits(rng, state):
+    kind = rng.randrange(7)
+    if kind == 0:
+        value = ''.join(rng.choice('\\; ') for _ in range(MAX_TAGS // 2))
+        return message(tags([('x', value)])[:MAX_TAGS + 1], 'PING')
+    if kind == 1:
+        return message('@' + 'x' * MAX_TAGS, 'PING')
+    if kind == 2:
+        section = ';'.join(string.ascii_letters[i % 52] for i in range(MAX_TAGS // 2))
+        return message('@' + section, 'PING')
+    if kind == 3:
+        return message('', 'PRIVMSG ' + ' '.join('x' * rng.randint(1, 2) for _ in range(170)))
+    if kind == 4:
+        return message('', 'PRIVMSG' + ' ' * (MAX_BODY - 12) + 'a :b')
+    if kind == 5:
+        return message('', f':{"x" * (MAX_BODY - 10)} PING')
+    return message(tags([(f'k{i}', '') for i in range(1000)])[:MAX_TAGS + 1],
+                   f'PRIVMSG #a :{":" * (MAX_BODY - 12)}')
+
+# What a hostile peer sends: lines past the limits, sections that never
+# end, stray and doubled CRs, NULs and empty tag names, among the valid
+# but slow lines of the limits profile. A line can't hold a lone LF, as
+# the benchmarks split the corpus into messages on those.
+def adversarial(rng, state):
+    kind = rng.randrange(10)
+    if kind == 0:
+        return 'PRIVMSG #a :' + 'x' * rng.randint(MAX_BODY, 4 * MAX_BODY)
+    if kind == 1:
+        return '@' + 'x' * (MAX_TAGS + rng.randint(1, 1000)) + ' PING'
+    if kind == 2:
+        return tags((f'k{i}', 'v') for i in range(rng.randint(1, 50)))
+    if kind == 3:
+        return f':{mask(rng)}' + ' ' * rng.randint(0, 3)
+    if kind == 4:
+        return f'PRIVMSG {channel(rng)} :{sentence(rng, 1, 10)}\r{sentence(rng, 1, 10)}'
+    if kind == 5:
+        # The benchmarks drop one CR at the end of a line, and add a
+        # CRLF, so this ends in a CRCR.
+        return f'PING :{host(rng)}\r\r'
+    if kind == 6:
+        return f'PRIVMSG {channel(rng)} :{sentence(rng, 1, 5)}\0{sentence(rng, 1, 5)}'
+    if kind == 7:
+        return f'@=x;;=y;{"=" * rng.randint(1, 8)} :{mask(rng)} PING'
+    if kind == 8:
+        return ' ' * rng.randint(1, MAX_BODY)
+    return limits(rng, state)
+
+# A bit of everything a client sees on a typical day, mostly chat, for
+# profile-guided builds to train on. A netsplit, once started, runs its
+# course before anything else comes in.
+def mixed(rng, state):
+    if state.get('burst'):
+        return netsplit(rng, state)
+    generate = rng.choices((twitch, netsplit, numerics, ctcp), weights=(70, 0.1, 18, 10))[0]
+    return generate(rng, state)
+
+PROFILES = {
+    'twitch': twitch,
+    'netsplit': netsplit,
+    'ctcp': ctcp,
+    'numerics': numerics,
+    'limits': limits,
+    'adversarial': adversarial,
+    'mixed': mixed,
+}
+
+def main():
+    parser = argparse.ArgumentParser(description='Generates an IRC traffic corpus.')
+    parser.add_argument('profile', choices=sorted(PROFILES))
+    parser.add_argument('output')
+    parser.add_argument('--messages', type=int, default=20000)
+    parser.add_argument('--seed', type=int, default=1)
+    args = parser.parse_args()
+
+    rng = random.Random(f'{args.profile}/{args.seed}')
+    generate = PROFILES[args.profile]
+    # Whatever a profile needs to remember from one message to the next.
+    state = {}
+    with open(args.output, 'wb') as output:
+        for _ in range(args.messages):
+            line = generate(rng, state)
+            output.write(line.encode('utf-8') + b'\n')
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,41 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "bench.h"
+
+static size_t
+parse_pass(const struct bench_corpus *corpus, void *ctx)
+{
+	size_t events = 0;
+	size_t start = 0;
+	for (size_t i = 0; i < corpus->count; ++i) {
+		events += ircmsg_parse(corpus->data + start,
+				       corpus->ends[i] - start,
+				       &bench_parser_cbs, &events);
+		start = corpus->ends[i];
+	}
+	return events;
+}
+
+int
+main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "ircmsg_parse", NULL, NULL, parse_pass);
+}
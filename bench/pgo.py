@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Jani Juhani Sinervo
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Builds ircmsg as a static library with link-time optimization twice:
+# once as is, and once optimized with the profile of the roundtrip
+# benchmark, which parses and serializes every message, running over the
+# training corpus. Then reports how much faster the second build went
+# over said corpus.
+#
+# Usage: pgo.py SOURCE_DIR BUILD_DIR [--meson MESON] [--messages N] [--no-lto]
+
+import argparse
+import glob
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+def run(*command, **kwargs):
+    print('+', ' '.join(command), flush=True)
+    return subprocess.run(command, check=True, **kwargs)
+
+def setup(meson, source_dir, build_dir, options):
+    # Wiping an old build also gets rid of any profile left in it.
+    wipe = ['--wipe'] if os.path.isdir(os.path.join(build_dir, 'meson-private')) else []
+    run(meson, 'setup', *wipe, build_dir, source_dir, *options)
+
+def bench(build_dir, corpora):
+    output = run(os.path.join(build_dir, 'bench', 'roundtrip_bench'), *corpora,
+                 stdout=subprocess.PIPE, universal_newlines=True).stdout
+    return [json.loads(line) for line in output.splitlines()]
+
+def main():
+    parser = argparse.ArgumentParser(description='Measures what profile-guided optimization does for ircmsg.')
+    parser.add_argument('source_dir')
+    parser.add_argument('build_dir')
+    parser.add_argument('--meson', default=shutil.which('meson') or 'meson')
+    parser.add_argument('--messages', type=int, default=20000,
+                        help='how many messages of mixed traffic to train on')
+    parser.add_argument('--no-lto', dest='lto', action='store_false')
+    args = parser.parse_args()
+
+    os.makedirs(args.build_dir, exist_ok=True)
+    training = os.path.join(args.build_dir, 'mixed.txt')
+    run(sys.executable, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'gen_corpus.py'),
+        'mixed', training, '--messages', str(args.messages))
+    corpora = [training] + sorted(glob.glob(os.path.join(args.source_dir, 'bench', 'corpus', '*.txt')))
+
+    options = ['--buildtype=release', '-Ddefault_library=static',
+               '-Db_lto=' + ('true' if args.lto else 'false'),
+               '-Dtests=false', '-Dbenchmarks=true']
+    plain = os.path.join(args.build_dir, 'plain')
+    profiled = os.path.join(args.build_dir, 'profiled')
+
+    setup(args.meson, args.source_dir, plain, options)
+    run(args.meson, 'compile', '-C', plain)
+    before = bench(plain, corpora)
+
+    # The first stage only has to run the training, as its own numbers
+    # are skewed by the instrumentation.
+    setup(args.meson, args.source_dir, profiled, options + ['-Db_pgo=generate'])
+    run(args.meson, 'compile', '-C', profiled)
+    bench(profiled, corpora)
+    run(args.meson, 'configure', profiled, '-Db_pgo=use')
+    run(args.meson, 'compile', '-C', profiled)
+    after = bench(profiled, corpora)
+
+    report = []
+    print()
+    for old, new in zip(before, after):
+        delta = new['messages_per_sec'] / old['messages_per_sec'] - 1
+        report.append({'corpus': old['corpus'],
+                       'before_messages_per_sec': old['messages_per_sec'],
+                       'after_messages_per_sec': new['messages_per_sec'],
+                       'delta': delta})
+        print(f"{old['corpus']}: {old['messages_per_sec']:.0f} -> "
+              f"{new['messages_per_sec']:.0f} messages/s ({delta:+.1%})")
+    with open(os.path.join(args.build_dir, 'pgo.json'), 'w') as output:
+        json.dump(report, output, indent=2)
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,63 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "bench.h"
+
+// What a client does with most of its traffic: parse each message, and
+// serialize one back.
+
+static bool
+messages_setup(const struct bench_corpus *corpus, void **ctx)
+{
+	*ctx = bench_messages_load(corpus);
+	return *ctx != NULL;
+}
+
+static void
+messages_teardown(const struct bench_corpus *corpus, void *ctx)
+{
+	bench_messages_free(ctx, corpus->count);
+}
+
+static size_t
+roundtrip_pass(const struct bench_corpus *corpus, void *ctx)
+{
+	struct bench_message *messages = ctx;
+	static uint8_t out[IRCMSG_PARSER_MAX_TAGS_LEN + IRCMSG_PARSER_MAX_BODY_LEN];
+	size_t events = 0;
+	size_t start = 0;
+	for (size_t i = 0; i < corpus->count; ++i) {
+		events += ircmsg_parse(corpus->data + start,
+				       corpus->ends[i] - start,
+				       &bench_parser_cbs, &events);
+		ircmsg_serialize(out, sizeof(out), &bench_serializer_cbs,
+				 &messages[i]);
+		events += out[0];
+		start = corpus->ends[i];
+	}
+	return events;
+}
+
+int
+main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "roundtrip",
+			  messages_setup, messages_teardown, roundtrip_pass);
+}
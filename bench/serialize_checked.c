@@ -0,0 +1,62 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// Serializes each message the way one would without knowing it fits,
+// into a buffer only as large as IRC messages are usually allowed to
+// be, with ircmsg_serialize_checked. Compare with the sum of the
+// ircmsg_serialize_buffer_len and ircmsg_serialize benchmarks.
+
+#include "bench.h"
+
+static bool
+messages_setup(const struct bench_corpus *corpus, void **ctx)
+{
+	*ctx = bench_messages_load(corpus);
+	return *ctx != NULL;
+}
+
+static void
+messages_teardown(const struct bench_corpus *corpus, void *ctx)
+{
+	bench_messages_free(ctx, corpus->count);
+}
+
+static size_t
+checked_pass(const struct bench_corpus *corpus, void *ctx)
+{
+	struct bench_message *messages = ctx;
+	static uint8_t out[IRCMSG_PARSER_MAX_TAGS_LEN + IRCMSG_PARSER_MAX_BODY_LEN];
+	size_t total = 0;
+	for (size_t i = 0; i < corpus->count; ++i) {
+		bool truncated = false;
+		total += ircmsg_serialize_checked(out, sizeof(out),
+						  &bench_serializer_cbs,
+						  &messages[i], &truncated);
+		total += truncated;
+	}
+	return total;
+}
+
+int
+main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "ircmsg_serialize_checked",
+			  messages_setup, messages_teardown, checked_pass);
+}
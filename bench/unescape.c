@@ -0,0 +1,66 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "bench.h"
+
+// The longest a tag value can be, unescaped, within the default limits.
+static uint8_t out[IRCMSG_PARSER_MAX_TAGS_LEN];
+
+static bool
+messages_setup(const struct bench_corpus *corpus, void **ctx)
+{
+	*ctx = bench_messages_load(corpus);
+	return *ctx != NULL;
+}
+
+static void
+messages_teardown(const struct bench_corpus *corpus, void *ctx)
+{
+	bench_messages_free(ctx, corpus->count);
+}
+
+static size_t
+unescape_pass(const struct bench_corpus *corpus, void *ctx)
+{
+	const struct bench_message *messages = ctx;
+	size_t total = 0;
+	for (size_t i = 0; i < corpus->count; ++i) {
+		const ircmsg_message_view *view = &messages[i].view;
+		for (size_t tag = 0; tag < view->tag_count; ++tag) {
+			const uint8_t *value =
+				messages[i].buf + view->tags[tag].value.offset;
+			size_t value_len = view->tags[tag].value.len;
+			if (value_len == 0) continue;
+
+			size_t len = ircmsg_tag_value_unescaped_size(value, value_len);
+			const uint8_t *unescaped = ircmsg_tag_value_unescape(
+				value, value_len, out, sizeof(out));
+			total += len + (unescaped != NULL);
+		}
+	}
+	return total;
+}
+
+int
+main(int argc, char **argv)
+{
+	return bench_main(argc, argv, "ircmsg_tag_value_unescape",
+			  messages_setup, messages_teardown, unescape_pass);
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __COMMAND_H_
+#define __COMMAND_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * Identifies the command of a message without comparing strings.
+ *
+ * A three-digit numeric reply is identified by its value, from 0 to 999.
+ * The named commands come after those, and any command not listed here
+ * is IRCMSG_CMD_UNKNOWN.
+ *
+ * The lookup table for the named commands is generated from this enum by
+ * src/command_table.py, so adding a command here is all that is needed.
+ */
+typedef enum {
+	IRCMSG_CMD_NUMERIC_MAX = 999,
+
+	IRCMSG_CMD_UNKNOWN = 1000,
+
+	/* RFC 1459 and RFC 2812 */
+	IRCMSG_CMD_ADMIN,
+	IRCMSG_CMD_AWAY,
+	IRCMSG_CMD_CONNECT,
+	IRCMSG_CMD_DIE,
+	IRCMSG_CMD_ERROR,
+	IRCMSG_CMD_INFO,
+	IRCMSG_CMD_INVITE,
+	IRCMSG_CMD_ISON,
+	IRCMSG_CMD_JOIN,
+	IRCMSG_CMD_KICK,
+	IRCMSG_CMD_KILL,
+	IRCMSG_CMD_LINKS,
+	IRCMSG_CMD_LIST,
+	IRCMSG_CMD_LUSERS,
+	IRCMSG_CMD_MODE,
+	IRCMSG_CMD_MOTD,
+	IRCMSG_CMD_NAMES,
+	IRCMSG_CMD_NICK,
+	IRCMSG_CMD_NJOIN,
+	IRCMSG_CMD_NOTICE,
+	IRCMSG_CMD_OPER,
+	IRCMSG_CMD_PART,
+	IRCMSG_CMD_PASS,
+	IRCMSG_CMD_PING,
+	IRCMSG_CMD_PONG,
+	IRCMSG_CMD_PRIVMSG,
+	IRCMSG_CMD_QUIT,
+	IRCMSG_CMD_REHASH,
+	IRCMSG_CMD_RESTART,
+	IRCMSG_CMD_SERVER,
+	IRCMSG_CMD_SERVICE,
+	IRCMSG_CMD_SERVLIST,
+	IRCMSG_CMD_SQUERY,
+	IRCMSG_CMD_SQUIT,
+	IRCMSG_CMD_STATS,
+	IRCMSG_CMD_SUMMON,
+	IRCMSG_CMD_TIME,
+	IRCMSG_CMD_TOPIC,
+	IRCMSG_CMD_TRACE,
+	IRCMSG_CMD_USER,
+	IRCMSG_CMD_USERHOST,
+	IRCMSG_CMD_USERS,
+	IRCMSG_CMD_VERSION,
+	IRCMSG_CMD_WALLOPS,
+	IRCMSG_CMD_WHO,
+	IRCMSG_CMD_WHOIS,
+	IRCMSG_CMD_WHOWAS,
+
+	/* IRCv3 */
+	IRCMSG_CMD_ACCOUNT,
+	IRCMSG_CMD_AUTHENTICATE,
+	IRCMSG_CMD_BATCH,
+	IRCMSG_CMD_CAP,
+	IRCMSG_CMD_CHATHISTORY,
+	IRCMSG_CMD_CHGHOST,
+	IRCMSG_CMD_FAIL,
+	IRCMSG_CMD_MARKREAD,
+	IRCMSG_CMD_MONITOR,
+	IRCMSG_CMD_NOTE,
+	IRCMSG_CMD_REDACT,
+	IRCMSG_CMD_SETNAME,
+	IRCMSG_CMD_TAGMSG,
+	IRCMSG_CMD_WARN,
+	IRCMSG_CMD_WEBIRC,
+
+	IRCMSG_CMD_END
+} ircmsg_command_id;
+
+#define IRCMSG_CMD_IS_NUMERIC(id) ((id) <= IRCMSG_CMD_NUMERIC_MAX)
+
+/*
+ * Returns the ID of the given command, matched case-insensitively.
+ * Numerics must be exactly three digits long.
+ */
+ircmsg_command_id
+ircmsg_command_classify(const uint8_t *command, size_t command_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/command.h */
@@ -0,0 +1,117 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __DISPATCH_H_
+#define __DISPATCH_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <ircmsg/command.h>
+#include <ircmsg/parser.h>
+
+/*
+ * Handles a message, found in `buf` and described by `view`, whose
+ * spans are offsets from `buf`.
+ */
+typedef void (*ircmsg_handler)(const uint8_t *buf,
+			       const ircmsg_message_view *view,
+			       void *user_data);
+
+/*
+ * Which handler each command goes to, indexed by its
+ * `ircmsg_command_id`, so that a numeric goes to the handler at its
+ * value, and the commands not listed in `ircmsg_command_id` to the one
+ * at `IRCMSG_CMD_UNKNOWN`. Commands without a handler go to `fallback`
+ * instead, and are dropped if that is NULL too.
+ *
+ * The table holds no pointers to anything else, so it can be filled
+ * in statically with designated initializers:
+ *
+ *     static const ircmsg_dispatch_table table = {
+ *             .handlers = {
+ *                     [IRCMSG_CMD_PRIVMSG] = on_privmsg,
+ *                     [1] = on_welcome,
+ *             },
+ *             .fallback = on_anything_else,
+ *     };
+ */
+typedef struct
+{
+	ircmsg_handler handlers[IRCMSG_CMD_END];
+	ircmsg_handler fallback;
+} ircmsg_dispatch_table;
+
+/*
+ * Parses a single IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), into `view`, like `ircmsg_parse_to_view`,
+ * and hands it to its handler in `table`.
+ *
+ * Returns the number of bytes consumed, or 0 in case of an error, in
+ * which case no handler is called and the error is in `view->error`.
+ */
+size_t
+ircmsg_dispatch(const ircmsg_dispatch_table *table,
+		const uint8_t *buf,
+		size_t buf_size,
+		ircmsg_message_view *view,
+		void *user_data);
+
+/*
+ * Same as `ircmsg_dispatch`, but with `limits` instead of the default
+ * ones, unless it is NULL, like `ircmsg_parse_to_view_ex`.
+ */
+size_t
+ircmsg_dispatch_ex(const ircmsg_dispatch_table *table,
+		   const uint8_t *buf,
+		   size_t buf_size,
+		   ircmsg_message_view *view,
+		   void *user_data,
+		   const ircmsg_parser_limits *limits);
+
+/*
+ * Does the same as `ircmsg_dispatch` for every complete IRC message in
+ * `buf`, in range [`buf`, `buf+buf_size`), in turn, reusing `view`.
+ *
+ * Returns the number of bytes consumed, like `ircmsg_parse_batch`.
+ */
+size_t
+ircmsg_dispatch_batch(const ircmsg_dispatch_table *table,
+		      const uint8_t *buf,
+		      size_t buf_size,
+		      ircmsg_message_view *view,
+		      void *user_data);
+
+size_t
+ircmsg_dispatch_batch_ex(const ircmsg_dispatch_table *table,
+			 const uint8_t *buf,
+			 size_t buf_size,
+			 ircmsg_message_view *view,
+			 void *user_data,
+			 const ircmsg_parser_limits *limits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/dispatch.h */
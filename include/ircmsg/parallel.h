@@ -0,0 +1,183 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __PARALLEL_H_
+#define __PARALLEL_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <ircmsg/parser.h>
+
+/*
+ * The most threads an `ircmsg_parallel_pool` can have.
+ */
+#define IRCMSG_PARALLEL_MAX_THREADS 64
+
+/*
+ * One of the pieces a buffer is split into by `ircmsg_parse_parallel`,
+ * and how parsing it went.
+ *
+ * The chunk covers [`buf+offset`, `buf+offset+len`) and starts with
+ * message number `first_message` of the buffer, counting from 0.
+ * `consumed` and `message_count` tell how much of it was parsed,
+ * which is all of it unless `failed` is set.
+ */
+typedef struct
+{
+	size_t offset;
+	size_t len;
+	size_t first_message;
+	size_t message_count;
+	size_t consumed;
+	bool failed;
+} ircmsg_parallel_chunk;
+
+/*
+ * Parses every complete IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), like `ircmsg_parse_batch`, but on
+ * `chunk_count` threads at once.
+ *
+ * The buffer is split at message boundaries into `chunk_count`
+ * chunks of about the same size, described in `chunks`. Each chunk is
+ * parsed from start to end by a thread of its own, calling the
+ * callbacks in `cbs` with `user_data[i]` for chunk `i`, so the
+ * callbacks of different chunks may run at the same time, but those
+ * of the same chunk are called in order. Going through the chunks in
+ * order therefore gives the messages in the order they are in `buf`,
+ * and `first_message` numbers them.
+ *
+ * How a buffer is split only depends on its contents and
+ * `chunk_count`, so the results are the same on every run.
+ *
+ * A chunk stops at its first error, but the others carry on. Returns
+ * the number of bytes consumed up to the first error, or up to the
+ * start of the trailing incomplete message, like `ircmsg_parse_batch`.
+ *
+ * The threads are started for this call and joined before it
+ * returns, at most `IRCMSG_PARALLEL_MAX_THREADS` of them, which then
+ * share the chunks. To parse many buffers, keep the threads around
+ * between calls with an `ircmsg_parallel_pool` instead.
+ */
+size_t
+ircmsg_parse_parallel(const uint8_t *buf,
+		      size_t buf_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      void *const *user_data,
+		      ircmsg_parallel_chunk *chunks,
+		      size_t chunk_count);
+
+/*
+ * Same as `ircmsg_parse_parallel`, but with `limits` instead of the
+ * default ones, unless it is NULL.
+ */
+size_t
+ircmsg_parse_parallel_ex(const uint8_t *buf,
+			 size_t buf_size,
+			 const ircmsg_parser_callbacks *cbs,
+			 void *const *user_data,
+			 ircmsg_parallel_chunk *chunks,
+			 size_t chunk_count,
+			 const ircmsg_parser_limits *limits);
+
+/*
+ * Threads kept waiting for buffers to parse with
+ * `ircmsg_parse_parallel_pool`, so that they don't have to be started
+ * for every buffer.
+ *
+ * The fields are private to the parser. The pool lives wherever the
+ * user puts it, and is set up with `ircmsg_parallel_pool_init` and
+ * torn down with `ircmsg_parallel_pool_destroy`.
+ */
+typedef struct
+{
+	pthread_t threads[IRCMSG_PARALLEL_MAX_THREADS];
+	size_t thread_count;
+	pthread_mutex_t lock;
+	pthread_cond_t work_ready;
+	pthread_cond_t work_done;
+	unsigned long generation;
+	bool stopping;
+
+	const uint8_t *buf;
+	const ircmsg_parser_callbacks *cbs;
+	void *const *user_data;
+	const ircmsg_parser_limits *limits;
+	ircmsg_parallel_chunk *chunks;
+	size_t chunk_count;
+	size_t next_chunk;
+	size_t chunks_done;
+} ircmsg_parallel_pool;
+
+/*
+ * Starts `thread_count` threads in `pool`, at most
+ * `IRCMSG_PARALLEL_MAX_THREADS`. Should the system refuse to start
+ * some of them, the pool makes do with the ones it got.
+ *
+ * Returns false if `thread_count` is too large or the pool couldn't
+ * be set up at all, in which case it mustn't be used or destroyed.
+ */
+bool
+ircmsg_parallel_pool_init(ircmsg_parallel_pool *pool, size_t thread_count);
+
+/*
+ * Stops and joins the threads of `pool`.
+ */
+void
+ircmsg_parallel_pool_destroy(ircmsg_parallel_pool *pool);
+
+/*
+ * Does the same as `ircmsg_parse_parallel`, but on the threads of
+ * `pool`, with the calling thread helping out. The chunks are handed
+ * to the threads as they become free, so there may be more chunks
+ * than threads, which evens out chunks that take longer than others.
+ *
+ * A pool parses one buffer at a time: it mustn't be given another
+ * from a second thread before this returns.
+ */
+size_t
+ircmsg_parse_parallel_pool(ircmsg_parallel_pool *pool,
+			   const uint8_t *buf,
+			   size_t buf_size,
+			   const ircmsg_parser_callbacks *cbs,
+			   void *const *user_data,
+			   ircmsg_parallel_chunk *chunks,
+			   size_t chunk_count);
+
+size_t
+ircmsg_parse_parallel_pool_ex(ircmsg_parallel_pool *pool,
+			      const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_callbacks *cbs,
+			      void *const *user_data,
+			      ircmsg_parallel_chunk *chunks,
+			      size_t chunk_count,
+			      const ircmsg_parser_limits *limits);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/parallel.h */
@@ -27,12 +27,18 @@ extern "C" {
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <ircmsg/command.h>
 
 typedef enum
 {
 	IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND,
 	IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE,
 	IRCMSG_ERR_PARSER_INVALID_SENTINEL,
+	IRCMSG_ERR_PARSER_VIEW_OVERFLOW,
+	IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG,
+
+	IRCMSG_ERR_PARSER_END
 } ircmsg_parser_err_code;
 
 typedef struct
@@ -61,6 +67,32 @@ typedef struct
 	void (*const on_error)(ircmsg_parser_err_code error, void *user_data);
 } ircmsg_parser_callbacks;
 
+/*
+ * The limits from the IRC specs: 512 bytes for a message, including
+ * its CRLF, and 8191 bytes for its tags, including the leading '@'
+ * and the space after them.
+ */
+#define IRCMSG_PARSER_MAX_BODY_LEN 512
+#define IRCMSG_PARSER_MAX_TAGS_LEN 8191
+
+/*
+ * How long a message may be before the parser gives up on it with
+ * `IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG`, without looking any further,
+ * so that the work done on each message stays bounded whatever the
+ * other party sends.
+ *
+ * `max_tags_len` counts from the start of the message up to and
+ * including the space that ends its tags. `max_body_len` counts the
+ * rest of the message, or all of it if there are no tags, including
+ * the two bytes of a CRLF at its end. Either may be set to SIZE_MAX
+ * to lift the limit.
+ */
+typedef struct
+{
+	size_t max_tags_len;
+	size_t max_body_len;
+} ircmsg_parser_limits;
+
 /*
  * Parses a single IRC message in `buf`, in range
  * [`buf`, `buf+buf_size`).
@@ -74,6 +106,425 @@ ircmsg_parse(const uint8_t *buf,
 	     const ircmsg_parser_callbacks *cbs,
 	     void *user_data);
 
+/*
+ * Same as `ircmsg_parse`, but with `limits` instead of the default
+ * ones, unless it is NULL. Every other function that parses whole
+ * buffers, including those in <ircmsg/dispatch.h>, has an `_ex`
+ * variant like this one.
+ */
+size_t
+ircmsg_parse_ex(const uint8_t *buf,
+		size_t buf_size,
+		const ircmsg_parser_callbacks *cbs,
+		void *user_data,
+		const ircmsg_parser_limits *limits);
+
+/*
+ * Parses every complete IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), calling the callbacks for each of them
+ * in turn.
+ *
+ * Returns the number of bytes consumed, which is where the first
+ * incomplete message in `buf` starts. If a message fails to parse,
+ * parsing stops and the return value points to the start of said
+ * message (see the error callback).
+ */
+size_t
+ircmsg_parse_batch(const uint8_t *buf,
+		   size_t buf_size,
+		   const ircmsg_parser_callbacks *cbs,
+		   void *user_data);
+
+size_t
+ircmsg_parse_batch_ex(const uint8_t *buf,
+		      size_t buf_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      void *user_data,
+		      const ircmsg_parser_limits *limits);
+
+/*
+ * How many messages failed to parse with each error, indexed by the
+ * error code, as counted by `ircmsg_parse_batch_recover`.
+ */
+typedef struct
+{
+	size_t counts[IRCMSG_ERR_PARSER_END];
+} ircmsg_parser_error_counts;
+
+/*
+ * Parses every complete IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), like `ircmsg_parse_batch`, except that a
+ * message that fails to parse doesn't stop parsing. Its error is
+ * reported as usual and counted in `errors`, if not NULL, and parsing
+ * carries on after the terminator that ends it. Empty lines, such as
+ * the rest of a CRCR, are skipped over without an error.
+ *
+ * Returns the number of bytes consumed, which is where the first
+ * incomplete message in `buf` starts.
+ */
+size_t
+ircmsg_parse_batch_recover(const uint8_t *buf,
+			   size_t buf_size,
+			   const ircmsg_parser_callbacks *cbs,
+			   void *user_data,
+			   ircmsg_parser_error_counts *errors);
+
+size_t
+ircmsg_parse_batch_recover_ex(const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_callbacks *cbs,
+			      void *user_data,
+			      ircmsg_parser_error_counts *errors,
+			      const ircmsg_parser_limits *limits);
+
+/*
+ * What the parser should do next, as returned by the callbacks in
+ * `ircmsg_parser_control_callbacks`.
+ */
+typedef enum
+{
+	// Carry on parsing the message.
+	IRCMSG_PARSER_CONTINUE,
+	// Skip straight to the end of the message, without calling any
+	// more callbacks for it, not even `end_message`.
+	IRCMSG_PARSER_SKIP_MESSAGE,
+	// Stop parsing altogether.
+	IRCMSG_PARSER_ABORT,
+} ircmsg_parser_control;
+
+/*
+ * The same callbacks as in `ircmsg_parser_callbacks`, except that each
+ * of them tells the parser how to go on. Any of them may be NULL, in
+ * which case it is not called.
+ */
+typedef struct
+{
+	ircmsg_parser_control (*const start_message)(void *user_data);
+
+	ircmsg_parser_control (*const start_tags)(void *user_data);
+	ircmsg_parser_control (*const on_tag)(const uint8_t *name, size_t name_len,
+					      const uint8_t *esc_value,
+					      size_t esc_value_len,
+					      void *user_data);
+	ircmsg_parser_control (*const end_tags)(void *user_data);
+
+	ircmsg_parser_control (*const on_prefix)(const uint8_t *prefix,
+						 size_t prefix_len,
+						 void *user_data);
+
+	ircmsg_parser_control (*const on_command)(const uint8_t *command,
+						  size_t command_len,
+						  void *user_data);
+
+	ircmsg_parser_control (*const start_params)(void *user_data);
+	ircmsg_parser_control (*const on_param)(const uint8_t *param,
+						size_t param_len,
+						void *user_data);
+	ircmsg_parser_control (*const end_params)(void *user_data);
+
+	ircmsg_parser_control (*const end_message)(void *user_data);
+
+	void (*const on_error)(ircmsg_parser_err_code error, void *user_data);
+} ircmsg_parser_control_callbacks;
+
+/*
+ * Parses every complete IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), like `ircmsg_parse_batch`, but lets the
+ * callbacks skip the rest of a message or stop parsing.
+ *
+ * Returns the number of bytes consumed. A skipped message counts as
+ * consumed. When parsing is aborted, the return value points to the
+ * start of the message being parsed, or past it if it was complete
+ * already, i.e. if `end_message` aborted.
+ */
+size_t
+ircmsg_parse_batch_controlled(const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_control_callbacks *cbs,
+			      void *user_data);
+
+size_t
+ircmsg_parse_batch_controlled_ex(const uint8_t *buf,
+				 size_t buf_size,
+				 const ircmsg_parser_control_callbacks *cbs,
+				 void *user_data,
+				 const ircmsg_parser_limits *limits);
+
+#define IRCMSG_TAG_FILTER_MAX 16
+
+/*
+ * A set of tag names that the user is interested in, built with
+ * `ircmsg_tag_filter_init`. Tags not in the set are skipped without
+ * calling `on_tag`.
+ *
+ * The fields are private to the parser.
+ */
+typedef struct
+{
+	uint64_t first_bytes[4];
+	size_t count;
+	const char *names[IRCMSG_TAG_FILTER_MAX];
+	size_t name_lens[IRCMSG_TAG_FILTER_MAX];
+} ircmsg_tag_filter;
+
+/*
+ * Builds a filter letting through the `name_count` tags in `names`.
+ * The names are not copied, so they must outlive the filter.
+ *
+ * Returns false, leaving `filter` as it was, if there are more than
+ * `IRCMSG_TAG_FILTER_MAX` names or one of them is empty.
+ */
+bool
+ircmsg_tag_filter_init(ircmsg_tag_filter *filter,
+		       const char *const *names,
+		       size_t name_count);
+
+/*
+ * Finds where each IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), ends, without parsing them, by looking for
+ * the same terminators as the parser: CRLF, LFCR, or a lone CR or LF.
+ *
+ * The offset just past the terminator of each message is written to
+ * `frame_ends`, until `frame_cap` of them have been found. A CR as the
+ * very last byte may be the start of a CRLF, so the message it ends is
+ * left out.
+ *
+ * Returns the number of offsets written. If a CRCR or LFLF, which the
+ * parser rejects, is found, the search stops there and `invalid` is
+ * set to true. Said terminator then ends the message after the last
+ * one found.
+ */
+size_t
+ircmsg_find_frames(const uint8_t *buf,
+		   size_t buf_size,
+		   size_t *frame_ends,
+		   size_t frame_cap,
+		   bool *invalid);
+
+/*
+ * Which part of a message `on_split_token` is given.
+ */
+typedef enum
+{
+	IRCMSG_SPLIT_TAG,
+	IRCMSG_SPLIT_PREFIX,
+	IRCMSG_SPLIT_COMMAND,
+	IRCMSG_SPLIT_PARAM,
+} ircmsg_split_kind;
+
+/*
+ * Called by `ircmsg_parse_segments` instead of `on_tag`, `on_prefix`,
+ * `on_command` or `on_param`, as told by `kind`, for the one part of
+ * a message that is split between the two segments. Said part is
+ * `first` followed by `second`. A tag is given as is, with both its
+ * name and escaped value.
+ */
+typedef void (*ircmsg_split_token_cb)(ircmsg_split_kind kind,
+				      const uint8_t *first, size_t first_len,
+				      const uint8_t *second, size_t second_len,
+				      void *user_data);
+
+/*
+ * Parses every complete IRC message in `first`, in range
+ * [`first`, `first+first_size`), followed by `second`, in range
+ * [`second`, `second+second_size`), like `ircmsg_parse_batch`, as if
+ * the two were one buffer, such as the two halves of a ring buffer.
+ *
+ * All callbacks are given parts of messages as usual, except for the
+ * one part that starts in `first` and ends in `second`, if any, which
+ * is given to `on_split_token` instead.
+ *
+ * Returns the number of bytes consumed from both segments together.
+ */
+size_t
+ircmsg_parse_segments(const uint8_t *first,
+		      size_t first_size,
+		      const uint8_t *second,
+		      size_t second_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      ircmsg_split_token_cb on_split_token,
+		      void *user_data);
+
+size_t
+ircmsg_parse_segments_ex(const uint8_t *first,
+			 size_t first_size,
+			 const uint8_t *second,
+			 size_t second_size,
+			 const ircmsg_parser_callbacks *cbs,
+			 ircmsg_split_token_cb on_split_token,
+			 void *user_data,
+			 const ircmsg_parser_limits *limits);
+
+/*
+ * The progress made on a message that has only been partially
+ * received, used by `ircmsg_parse_stream`.
+ *
+ * The fields are private to the parser, except for `tag_filter`,
+ * which may be set to only be told about some of the tags, and
+ * `limits`, which start out as `IRCMSG_PARSER_MAX_TAGS_LEN` and
+ * `IRCMSG_PARSER_MAX_BODY_LEN`. Initialize the struct with
+ * `ircmsg_parser_state_init` before first use.
+ */
+typedef struct
+{
+	int parsing_state;
+	size_t head;
+	size_t scanned;
+	size_t body_start;
+	bool message_started;
+	bool params_started;
+	bool tags_open;
+	bool skip_cr;
+	size_t tag_count;
+	size_t param_count;
+
+	const ircmsg_tag_filter *tag_filter;
+	ircmsg_parser_limits limits;
+} ircmsg_parser_state;
+
+void
+ircmsg_parser_state_init(ircmsg_parser_state *state);
+
+/*
+ * Parses every complete IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), like `ircmsg_parse_batch`, but also
+ * parses as much of the trailing incomplete message as it can,
+ * remembering how far it got in `state`.
+ *
+ * Returns the number of bytes consumed. The caller must pass the
+ * bytes after those again in the next call, followed by whatever it
+ * has received since. Parsing then resumes from where it stopped,
+ * without rescanning or calling any callbacks again for the part of
+ * the message that was already parsed.
+ *
+ * A message ending in an LF that is the last byte of `buf` is
+ * reported right away. Should the next call start with another LF,
+ * that LFLF is reported as `IRCMSG_ERR_PARSER_INVALID_SENTINEL` and
+ * nothing is consumed, as in `ircmsg_parse_batch`, except that the
+ * message before it has already been reported.
+ */
+size_t
+ircmsg_parse_stream(ircmsg_parser_state *state,
+		    const uint8_t *buf,
+		    size_t buf_size,
+		    const ircmsg_parser_callbacks *cbs,
+		    void *user_data);
+
+/*
+ * A part of a message, found in range
+ * [`buf+offset`, `buf+offset+len`) of the buffer that was parsed.
+ */
+typedef struct
+{
+	size_t offset;
+	size_t len;
+} ircmsg_span;
+
+typedef struct
+{
+	ircmsg_span name;
+	ircmsg_span value;
+} ircmsg_tag_span;
+
+/*
+ * The parts of a prefix, as found by `ircmsg_prefix_split`.
+ *
+ * A prefix is either the name of a server, in which case `is_server`
+ * is set and `name` is said name, or `nick!user@host`, in which case
+ * `name` is the nick and either of `user` and `host` may be missing.
+ * Missing parts have a length of 0.
+ */
+typedef struct
+{
+	bool is_server;
+	ircmsg_span name;
+	ircmsg_span user;
+	ircmsg_span host;
+} ircmsg_prefix_parts;
+
+/*
+ * Splits the prefix in `prefix` into its parts in a single pass. The
+ * offsets of the parts are from `prefix`.
+ */
+void
+ircmsg_prefix_split(const uint8_t *prefix,
+		    size_t prefix_len,
+		    ircmsg_prefix_parts *parts);
+
+/*
+ * Where the parts of a single message are, as filled in by
+ * `ircmsg_parse_to_view`.
+ *
+ * The `tags` and `params` arrays, and their capacities, are
+ * supplied by the caller, as are `lazy_tags` and `tag_filter`.
+ * Everything else is filled in by the parser.
+ *
+ * If `lazy_tags` is set, the tags are not split up into `tags`, and
+ * the whole tag section, without its leading '@', is recorded in
+ * `tag_section` instead. See `ircmsg_tags_find`.
+ *
+ * If `tag_filter` is set, only the tags in it are put in `tags`.
+ */
+typedef struct
+{
+	ircmsg_tag_span *tags;
+	size_t tags_cap;
+	ircmsg_span *params;
+	size_t params_cap;
+	bool lazy_tags;
+	const ircmsg_tag_filter *tag_filter;
+
+	size_t tag_count;
+	ircmsg_span tag_section;
+	bool has_prefix;
+	ircmsg_span prefix;
+	ircmsg_prefix_parts prefix_parts;
+	ircmsg_span command;
+	ircmsg_command_id command_id;
+	size_t param_count;
+
+	ircmsg_parser_err_code error;
+} ircmsg_message_view;
+
+/*
+ * Parses a single IRC message in `buf`, in range
+ * [`buf`, `buf+buf_size`), like `ircmsg_parse`, but instead of
+ * calling callbacks, records where each part of the message is in
+ * `view`.
+ *
+ * If parsing is successful, returns the number of bytes
+ * consumed, or 0 in case of an error, which is then stored in
+ * `view->error`. If the message has more tags or params than fit
+ * the caller's arrays, the error is `IRCMSG_ERR_PARSER_VIEW_OVERFLOW`
+ * and `view->tag_count` and `view->param_count` tell how many
+ * there are.
+ */
+size_t
+ircmsg_parse_to_view(const uint8_t *buf,
+		     size_t buf_size,
+		     ircmsg_message_view *view);
+
+size_t
+ircmsg_parse_to_view_ex(const uint8_t *buf,
+			size_t buf_size,
+			ircmsg_message_view *view,
+			const ircmsg_parser_limits *limits);
+
+/*
+ * Looks for the tag called `name` in a tag section, such as the one
+ * in `ircmsg_message_view.tag_section`, of `tags_len` bytes.
+ *
+ * Returns true if the tag is found, with its escaped value in
+ * `value` and `value_len`, just like with the `on_tag` callback.
+ * Otherwise returns false.
+ */
+bool
+ircmsg_tags_find(const uint8_t *tags,
+		 size_t tags_len,
+		 const char *name,
+		 const uint8_t **value,
+		 size_t *value_len);
+
 /*
  * This function tells the user how big a byte buffer has to be
  * to contain the passed tag value when said value gets unescaped.
@@ -100,6 +551,29 @@ ircmsg_tag_value_unescape(const uint8_t *esc_value,
 			  uint8_t *buf,
 			  size_t buf_len);
 
+/*
+ * Unescapes the tag value in `esc_value` into `buf` in a single pass,
+ * writing at most `buf_len` bytes.
+ *
+ * Returns the length of the unescaped value, which is never more than
+ * `esc_value_len`. If it is more than `buf_len`, the value did not fit
+ * and only its first `buf_len` bytes were written.
+ */
+size_t
+ircmsg_tag_value_unescape_into(const uint8_t *esc_value,
+			       size_t esc_value_len,
+			       uint8_t *buf,
+			       size_t buf_len);
+
+/*
+ * Unescapes the tag value in `value` over itself, such as right in
+ * the buffer the message was received into.
+ *
+ * Returns the length of the unescaped value.
+ */
+size_t
+ircmsg_tag_value_unescape_in_place(uint8_t *value, size_t value_len);
+
 #ifdef __cplusplus
 }
 #endif
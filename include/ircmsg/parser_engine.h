@@ -0,0 +1,1173 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// Internals of the message parser, shared between the library and
+// <ircmsg/parser_inline.h>. Nothing in here is part of the stable API;
+// use <ircmsg/parser.h> or <ircmsg/parser_inline.h> instead.
+
+#ifndef __PARSER_ENGINE_H_
+#define __PARSER_ENGINE_H_
+
+#include <ircmsg/parser.h>
+#include <stdbool.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define IRCMSG_SCAN_X86 1
+#define IRCMSG_SCAN_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+static inline bool
+ircmsg_is_irc_whitespace(uint8_t byte)
+{
+	// TODO: Add more byte "characters" that could be considered
+	// whitespace.
+        switch (byte)
+	{
+	case 0x20: // ASCII space
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Almost all of a message is made up of long runs of bytes that don't
+// matter to the state machine (nicks, hosts, message text), so
+// instead of feeding those through the main loop one at a time, we
+// look at as many bytes at once as the CPU lets us and jump straight
+// to the interesting one.
+//
+// Each of the scans below finds the first byte in [iter, end) that is
+// one of `a`, `b`, `c` or `d`, or returns `end` if there is none.
+// Callers that only care about fewer bytes simply repeat one of them.
+
+static inline const uint8_t *
+ircmsg_scan_bytes(const uint8_t *iter, const uint8_t *end,
+	   uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	for (; iter < end; ++iter) {
+		if (*iter == a || *iter == b || *iter == c || *iter == d)
+			break;
+	}
+	return iter;
+}
+
+// Without vector instructions we can still look at eight bytes at a
+// time with the classic "does this word have a zero byte" trick, after
+// XORing away each byte we're looking for.
+static inline const uint8_t *
+ircmsg_scan_swar(const uint8_t *iter, const uint8_t *end,
+	  uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	const uint64_t ones = UINT64_C(0x0101010101010101);
+	const uint64_t highs = UINT64_C(0x8080808080808080);
+	while (end - iter >= 8) {
+		uint64_t word;
+		memcpy(&word, iter, sizeof(word));
+		uint64_t xa = word ^ (ones * a);
+		uint64_t xb = word ^ (ones * b);
+		uint64_t xc = word ^ (ones * c);
+		uint64_t xd = word ^ (ones * d);
+		uint64_t hits = ((xa - ones) & ~xa) |
+			((xb - ones) & ~xb) |
+			((xc - ones) & ~xc) |
+			((xd - ones) & ~xd);
+		if ((hits & highs) != 0) break;
+		iter += 8;
+	}
+	return ircmsg_scan_bytes(iter, end, a, b, c, d);
+}
+
+#if defined(IRCMSG_SCAN_X86)
+IRCMSG_SCAN_TARGET("sse2") static inline const uint8_t *
+ircmsg_scan_sse2(const uint8_t *iter, const uint8_t *end,
+	  uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	const __m128i xa = _mm_set1_epi8((char) a);
+	const __m128i xb = _mm_set1_epi8((char) b);
+	const __m128i xc = _mm_set1_epi8((char) c);
+	const __m128i xd = _mm_set1_epi8((char) d);
+	while (end - iter >= 16) {
+		__m128i bytes = _mm_loadu_si128((const __m128i *) iter);
+		__m128i hits = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, xa),
+				     _mm_cmpeq_epi8(bytes, xb)),
+			_mm_or_si128(_mm_cmpeq_epi8(bytes, xc),
+				     _mm_cmpeq_epi8(bytes, xd)));
+		uint32_t mask = (uint32_t) _mm_movemask_epi8(hits);
+		if (mask != 0) return iter + __builtin_ctz(mask);
+		iter += 16;
+	}
+	return ircmsg_scan_bytes(iter, end, a, b, c, d);
+}
+
+IRCMSG_SCAN_TARGET("avx2") static inline const uint8_t *
+ircmsg_scan_avx2(const uint8_t *iter, const uint8_t *end,
+	  uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	const __m256i va = _mm256_set1_epi8((char) a);
+	const __m256i vb = _mm256_set1_epi8((char) b);
+	const __m256i vc = _mm256_set1_epi8((char) c);
+	const __m256i vd = _mm256_set1_epi8((char) d);
+	while (end - iter >= 32) {
+		__m256i bytes = _mm256_loadu_si256((const __m256i *) iter);
+		__m256i hits = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(bytes, va),
+					_mm256_cmpeq_epi8(bytes, vb)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(bytes, vc),
+					_mm256_cmpeq_epi8(bytes, vd)));
+		uint32_t mask = (uint32_t) _mm256_movemask_epi8(hits);
+		if (mask != 0) return iter + __builtin_ctz(mask);
+		iter += 32;
+	}
+	return ircmsg_scan_sse2(iter, end, a, b, c, d);
+}
+
+// With masked loads, the last few bytes need no loop of their own:
+// the bytes past `end` are masked off and never read.
+IRCMSG_SCAN_TARGET("avx512bw") static inline const uint8_t *
+ircmsg_scan_avx512(const uint8_t *iter, const uint8_t *end,
+	    uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+	const __m512i va = _mm512_set1_epi8((char) a);
+	const __m512i vb = _mm512_set1_epi8((char) b);
+	const __m512i vc = _mm512_set1_epi8((char) c);
+	const __m512i vd = _mm512_set1_epi8((char) d);
+	while (iter < end) {
+		__mmask64 valid = end - iter >= 64 ? ~(__mmask64) 0 :
+			((__mmask64) 1 << (end - iter)) - 1;
+		__m512i bytes = _mm512_maskz_loadu_epi8(valid, iter);
+		__mmask64 hits = (_mm512_cmpeq_epi8_mask(bytes, va) |
+				  _mm512_cmpeq_epi8_mask(bytes, vb) |
+				  _mm512_cmpeq_epi8_mask(bytes, vc) |
+				  _mm512_cmpeq_epi8_mask(bytes, vd)) & valid;
+		if (hits != 0) return iter + __builtin_ctzll(hits);
+		if (end - iter <= 64) return end;
+		iter += 64;
+	}
+	return iter;
+}
+#endif
+
+// The best of the scans above that the compiler was told it can use.
+static inline const uint8_t *
+ircmsg_scan_any(const uint8_t *iter, const uint8_t *end,
+	 uint8_t a, uint8_t b, uint8_t c, uint8_t d)
+{
+#if defined(IRCMSG_SCAN_X86) && defined(__AVX512BW__)
+	return ircmsg_scan_avx512(iter, end, a, b, c, d);
+#elif defined(IRCMSG_SCAN_X86) && defined(__AVX2__)
+	return ircmsg_scan_avx2(iter, end, a, b, c, d);
+#elif defined(IRCMSG_SCAN_X86) && defined(__SSE2__)
+	return ircmsg_scan_sse2(iter, end, a, b, c, d);
+#else
+	return ircmsg_scan_swar(iter, end, a, b, c, d);
+#endif
+}
+
+#if defined(IRCMSG_SCAN_DISPATCH)
+// When the library is built to pick its scans at run time, the
+// finders below go through these, which are set up for the CPU it
+// runs on when it is loaded. See ircmsg/simd.h. Switching levels
+// swaps the pointer to another set as a whole, so a scan may run with
+// either set but never with half of each.
+typedef struct
+{
+	const uint8_t *(*line_end)(const uint8_t *iter, const uint8_t *end);
+	const uint8_t *(*token_end)(const uint8_t *iter, const uint8_t *end);
+	const uint8_t *(*tag_end)(const uint8_t *iter, const uint8_t *end);
+	const uint8_t *(*escape)(const uint8_t *iter, const uint8_t *end);
+} ircmsg_scan_kernels;
+
+extern const ircmsg_scan_kernels *ircmsg_scan;
+
+#define IRCMSG_SCAN_FIND(kernel, iter, end, a, b, c, d)			\
+	__atomic_load_n(&ircmsg_scan, __ATOMIC_ACQUIRE)->kernel((iter), (end))
+#else
+#define IRCMSG_SCAN_FIND(kernel, iter, end, a, b, c, d)			\
+	ircmsg_scan_any((iter), (end), (a), (b), (c), (d))
+#endif
+
+// The end of a line: CR or LF.
+static inline const uint8_t *
+ircmsg_find_line_end(const uint8_t *iter, const uint8_t *end)
+{
+	return IRCMSG_SCAN_FIND(line_end, iter, end, '\r', '\n', '\r', '\n');
+}
+
+// The end of a prefix, a command or a middle param: whitespace or
+// the end of the line.
+static inline const uint8_t *
+ircmsg_find_token_end(const uint8_t *iter, const uint8_t *end)
+{
+	return IRCMSG_SCAN_FIND(token_end, iter, end, ' ', '\r', '\n', ' ');
+}
+
+// The end of a tag: the tag separator, whitespace or the end of the
+// line.
+static inline const uint8_t *
+ircmsg_find_tag_end(const uint8_t *iter, const uint8_t *end)
+{
+	return IRCMSG_SCAN_FIND(tag_end, iter, end, ';', ' ', '\r', '\n');
+}
+
+// The next backslash, which starts an escape in a tag value.
+static inline const uint8_t *
+ircmsg_find_escape(const uint8_t *iter, const uint8_t *end)
+{
+	return IRCMSG_SCAN_FIND(escape, iter, end, '\\', '\\', '\\', '\\');
+}
+
+// Returns the end of the last complete message in [buf, end), or buf
+// if there is none.
+static inline const uint8_t *
+ircmsg_find_complete_end(const uint8_t *buf, const uint8_t *end)
+{
+	const uint8_t *iter = end;
+
+	// A CR as the very last byte may well be the first half of a
+	// CRLF that hasn't arrived yet, so that message is not complete,
+	// unless said CR finishes an LFCR.
+	if (iter > buf && *(iter - 1) == '\r') {
+		if (iter - 1 > buf && *(iter - 2) == '\n') return iter;
+		--iter;
+	}
+
+	for (; iter > buf; --iter) {
+		if (*(iter - 1) == '\r' || *(iter - 1) == '\n') break;
+	}
+	return iter;
+}
+
+// The end of the first `max` bytes from `start`, or `end` if it comes
+// before that.
+static inline const uint8_t *
+ircmsg_limit_end(const uint8_t *start, const uint8_t *end, size_t max)
+{
+	return (size_t) (end - start) > max ? start + max : end;
+}
+
+// Splits the tag in [head, tail) into its name and its value.
+static inline void
+ircmsg_split_tag(const uint8_t *head,
+	  const uint8_t *tail,
+	  size_t *name_len_out,
+	  const uint8_t **value_out,
+	  size_t *value_len_out)
+{
+	const uint8_t *name_head = head;
+	size_t name_len = 0;
+
+	const uint8_t *value_head = NULL;
+        size_t value_len = 0;
+
+	const uint8_t *iter;
+	for (iter = head; iter < tail; ++iter) {
+		// Values are split from names with 0x3D '='.
+		if (*iter == 0x3D) {
+			name_len = iter - name_head;
+			value_head = iter + 1;
+		}
+	}
+
+	if (name_len == 0) name_len = iter - name_head;
+
+	if (value_head != NULL) {
+		value_len = iter - value_head;
+	}
+
+	// Empty tag values and no tag values are equivalent.
+	if (value_len == 0) {
+		value_head = NULL;
+	}
+
+	*name_len_out = name_len;
+	*value_out = value_head;
+	*value_len_out = value_len;
+}
+
+typedef enum {
+	// These states are "uninterruptable" as in if we encounter CRLF
+	// in any of these states, the parsing fails.
+	IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND,
+	IRCMSG_PARSING_TAGS,
+	IRCMSG_SEARCHING_PREFIX_COMMAND,
+	IRCMSG_PARSING_PREFIX,
+	IRCMSG_SEARCHING_COMMAND,
+	// These states are "interruptable" as in if we encounter CRLF,
+	// parsing succeeds.
+	IRCMSG_PARSING_COMMAND,
+	IRCMSG_SEARCHING_PARAMS,
+	IRCMSG_PARSING_PARAMS,
+	IRCMSG_PARSING_TRAILING_PARAM,
+	// The rest of the message is of no interest, so it ends without
+	// reporting anything.
+	IRCMSG_SKIPPING_MESSAGE,
+} ircmsg_parsing_state;
+
+typedef enum {
+	IRCMSG_PARSE_DONE,
+	IRCMSG_PARSE_NEED_MORE,
+	IRCMSG_PARSE_ERROR,
+	IRCMSG_PARSE_ABORTED,
+} ircmsg_parse_result;
+
+// The table-driven parser below only tells bytes apart by what they
+// can do to the state machine.
+typedef enum {
+	IRCMSG_CLASS_OTHER,
+	IRCMSG_CLASS_SPACE,
+	IRCMSG_CLASS_CR,
+	IRCMSG_CLASS_LF,
+	IRCMSG_CLASS_AT,
+	IRCMSG_CLASS_COLON,
+	IRCMSG_CLASS_SEMICOLON,
+} ircmsg_byte_class;
+
+// The class of each byte, and the transitions of the state machine
+// for each state and each class of byte. They live in
+// src/parser_dfa.c, so that this header stays valid C++ for
+// <ircmsg/parser_inline.h>.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern const uint8_t ircmsg_byte_classes[256];
+extern const uint8_t ircmsg_dfa_table[IRCMSG_SKIPPING_MESSAGE + 1][IRCMSG_CLASS_SEMICOLON + 1];
+
+#ifdef __cplusplus
+}
+#endif
+
+// What the table-driven parser does with a byte, before moving on to
+// the state the table gives along with it.
+typedef enum {
+	IRCMSG_DFA_NONE,
+	IRCMSG_DFA_SKIP_SPACE,
+	IRCMSG_DFA_START_TAGS,
+	IRCMSG_DFA_NEXT_TAG,
+	IRCMSG_DFA_END_TAGS,
+	IRCMSG_DFA_START_PREFIX,
+	IRCMSG_DFA_END_PREFIX,
+	IRCMSG_DFA_START_COMMAND,
+	IRCMSG_DFA_END_COMMAND,
+	IRCMSG_DFA_START_PARAM,
+	IRCMSG_DFA_START_TRAILING,
+	IRCMSG_DFA_END_PARAM,
+	// Every action from here on ends the message, one way or another.
+	IRCMSG_DFA_TERMINATE,
+	IRCMSG_DFA_UNEXPECTED_END,
+} ircmsg_dfa_action;
+
+#define IRCMSG_DFA(action, next) ((uint8_t) (((action) << 4) | (next)))
+#define IRCMSG_DFA_ACTION(entry) ((ircmsg_dfa_action) ((entry) >> 4))
+#define IRCMSG_DFA_NEXT(entry) ((ircmsg_parsing_state) ((entry) & 0x0F))
+
+// Whether the tag in [head, tail) is one of those let through by
+// `filter`.
+static inline bool
+ircmsg_tag_filter_wants(const ircmsg_tag_filter *filter,
+			const uint8_t *head,
+			const uint8_t *tail)
+{
+	if (head == tail) return false;
+
+	// Most unwanted tags are turned away by their first byte alone.
+	if (!((filter->first_bytes[*head >> 6] >> (*head & 63)) & 1)) {
+		return false;
+	}
+
+	size_t tag_len = tail - head;
+	for (size_t i = 0; i < filter->count; ++i) {
+		size_t name_len = filter->name_lens[i];
+		if (tag_len < name_len ||
+		    memcmp(head, filter->names[i], name_len) != 0) {
+			continue;
+		}
+
+		// The name may still go on past this, so split the tag
+		// the same way as for `on_tag` to be sure.
+		size_t tag_name_len;
+		const uint8_t *value;
+		size_t value_len;
+		ircmsg_split_tag(head, tail, &tag_name_len, &value, &value_len);
+		if (tag_name_len == name_len) return true;
+	}
+
+	return false;
+}
+
+// Puts `st` back to the start of a message.
+static inline void
+ircmsg_engine_reset(ircmsg_parser_state *st)
+{
+	st->parsing_state = IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND;
+	st->head = 0;
+	st->scanned = 0;
+	st->body_start = 0;
+	st->message_started = false;
+	st->params_started = false;
+	st->tags_open = false;
+	st->skip_cr = false;
+	st->tag_count = 0;
+	st->param_count = 0;
+}
+
+// Sets `st` up for a new connection, with no tag filter and the
+// default limits.
+static inline void
+ircmsg_engine_init(ircmsg_parser_state *st)
+{
+	ircmsg_engine_reset(st);
+	st->tag_filter = NULL;
+	st->limits.max_tags_len = IRCMSG_PARSER_MAX_TAGS_LEN;
+	st->limits.max_body_len = IRCMSG_PARSER_MAX_BODY_LEN;
+}
+
+// Same as `ircmsg_engine_init`, but with `limits` instead of the
+// default ones, unless it is NULL.
+static inline void
+ircmsg_engine_init_limits(ircmsg_parser_state *st,
+			  const ircmsg_parser_limits *limits)
+{
+	ircmsg_engine_init(st);
+	if (limits != NULL) st->limits = *limits;
+}
+
+#endif /* __PARSER_ENGINE_H_ */
+
+#ifdef IRCMSG_ENGINE_NAME
+
+// The message parser's state machine, written once and instantiated
+// for each way of reporting what it finds.
+//
+// The part below is generated each time this file is included with
+// the following defined:
+//
+// * IRCMSG_ENGINE_NAME, the name of the function to generate.
+// * IRCMSG_ENGINE_ARGS, any extra parameters for said function, starting
+//   with a comma.
+// * IRCMSG_ENGINE_START_MESSAGE(), IRCMSG_ENGINE_START_TAGS(), IRCMSG_ENGINE_ON_TAG(name,
+//   name_len, value, value_len), IRCMSG_ENGINE_ON_PREFIX(prefix, len),
+//   IRCMSG_ENGINE_ON_COMMAND(command, len), IRCMSG_ENGINE_START_PARAMS(),
+//   IRCMSG_ENGINE_ON_PARAM(param, len), IRCMSG_ENGINE_END_PARAMS(),
+//   IRCMSG_ENGINE_END_MESSAGE() and IRCMSG_ENGINE_ON_ERROR(error), which mirror
+//   the members of `ircmsg_parser_callbacks`.
+//
+// Optionally, IRCMSG_ENGINE_PARSE_TAG(head, tail) may be defined to
+// replace how the tag in [head, tail) is split and reported,
+// IRCMSG_ENGINE_TAG_FILTER may be defined to an expression
+// giving the `ircmsg_tag_filter` to apply, or NULL for none, and
+// IRCMSG_ENGINE_LAZY_TAGS may be defined to an expression
+// which, if true, makes the parser skip over the whole tag section at
+// once and report it with IRCMSG_ENGINE_ON_TAG_SECTION(section, len)
+// instead of reporting each tag. IRCMSG_ENGINE_CONTROL() may be defined
+// to give the `ircmsg_parser_control` asked for by the events reported
+// since it was last evaluated, to let them skip the rest of the message
+// or abort. IRCMSG_ENGINE_DFA may be defined to 1 to get the parser
+// that looks its transitions up in `ircmsg_dfa_table` rather than the
+// one that tests each byte against the states one branch at a time,
+// or to 0 for the latter; if it is not, IRCMSG_PARSER_DFA being defined
+// picks the former. Both report exactly the same events.
+//
+// All of them get undefined again at the end of this file.
+
+#ifndef IRCMSG_ENGINE_DFA
+#ifdef IRCMSG_PARSER_DFA
+#define IRCMSG_ENGINE_DFA 1
+#else
+#define IRCMSG_ENGINE_DFA 0
+#endif
+#endif
+
+#ifndef IRCMSG_ENGINE_TAG_FILTER
+#define IRCMSG_ENGINE_TAG_FILTER NULL
+#endif
+
+#ifndef IRCMSG_ENGINE_LAZY_TAGS
+#define IRCMSG_ENGINE_LAZY_TAGS false
+#endif
+
+#ifndef IRCMSG_ENGINE_ON_TAG_SECTION
+#define IRCMSG_ENGINE_ON_TAG_SECTION(section, section_len) ((void) 0)
+#endif
+
+#ifndef IRCMSG_ENGINE_CONTROL
+#define IRCMSG_ENGINE_CONTROL() IRCMSG_PARSER_CONTINUE
+#endif
+
+#ifndef IRCMSG_ENGINE_PARSE_TAG
+#define IRCMSG_ENGINE_PARSE_TAG(tag_head, tag_tail)				\
+	do {								\
+		const ircmsg_tag_filter *tag_filter =			\
+			IRCMSG_ENGINE_TAG_FILTER;			\
+		if (tag_filter != NULL &&				\
+		    !ircmsg_tag_filter_wants(tag_filter, (tag_head),	\
+					     (tag_tail))) {		\
+			break;						\
+		}							\
+		size_t tag_name_len;					\
+		const uint8_t *tag_value;				\
+		size_t tag_value_len;					\
+		ircmsg_split_tag((tag_head), (tag_tail), &tag_name_len,	\
+			  &tag_value, &tag_value_len);			\
+		IRCMSG_ENGINE_ON_TAG((tag_head), tag_name_len,			\
+			      tag_value, tag_value_len);		\
+	} while (false)
+#endif
+
+// Takes the control asked for by the events reported since it was
+// last taken, and acts on it: an abort makes the loop below stop
+// before reporting anything else, and a skip makes it report nothing
+// more of the message.
+#define IRCMSG_ENGINE_TAKE_CONTROL()						\
+	do {								\
+		ircmsg_parser_control control = IRCMSG_ENGINE_CONTROL();	\
+		if (control == IRCMSG_PARSER_ABORT) {			\
+			aborted = true;					\
+		} else if (control == IRCMSG_PARSER_SKIP_MESSAGE) {	\
+			current_state = IRCMSG_SKIPPING_MESSAGE;	\
+		}							\
+	} while (false)
+
+// Whether the events of the current message are still reported.
+#define IRCMSG_ENGINE_REPORTING()						\
+	(!aborted && current_state != IRCMSG_SKIPPING_MESSAGE)
+
+// Parses the message starting at `buf`, picking up from where `st`
+// says the previous call left off.
+//
+// If `at_end` is false, more bytes may still arrive after
+// `buf+buf_size`, so running out of them is not the end of the
+// message. In that case, `IRCMSG_PARSE_NEED_MORE` is returned, and `st` is
+// updated so that the next call can carry on from the same spot,
+// once the caller has appended more bytes after the ones in `buf`.
+//
+// Otherwise returns `IRCMSG_PARSE_DONE` and the number of bytes consumed in
+// `consumed`, or `IRCMSG_PARSE_ERROR` (see the error callback).
+static inline ircmsg_parse_result
+IRCMSG_ENGINE_NAME(ircmsg_parser_state *st,
+	    const uint8_t *buf,
+	    size_t buf_size,
+	    bool at_end,
+	    size_t *consumed
+	    IRCMSG_ENGINE_ARGS)
+{
+	size_t bytes_consumed = st->scanned;
+
+	bool hit_error = false;
+	bool finished = false;
+	bool aborted = false;
+	bool message_started = st->message_started;
+	bool params_started = st->params_started;
+	bool tags_open = st->tags_open;
+	ircmsg_parsing_state current_state = (ircmsg_parsing_state) st->parsing_state;
+
+	const uint8_t *head = buf + st->head;
+	const uint8_t *const end = buf + buf_size;
+	const uint8_t *iter;
+
+	// Nothing past the limits is ever looked at, so that no message
+	// can keep us scanning for longer than they allow. The body has
+	// to leave room for a CRLF, so its terminator must start one byte
+	// before its limit.
+	const size_t body_max = st->limits.max_body_len > 0 ?
+		st->limits.max_body_len - 1 : 0;
+	const uint8_t *body_start = buf + st->body_start;
+	const uint8_t *const tags_limit =
+		ircmsg_limit_end(buf, end, st->limits.max_tags_len);
+	const uint8_t *body_limit = ircmsg_limit_end(body_start, end, body_max);
+	for (iter = buf + st->scanned; iter < end; ++iter, ++bytes_consumed) {
+		IRCMSG_ENGINE_TAKE_CONTROL();
+		if (aborted) break;
+
+		// A message skipped in the middle of its tags is still held
+		// to the limit on them until they end.
+		const bool in_tags = current_state <= IRCMSG_PARSING_TAGS ||
+			(current_state == IRCMSG_SKIPPING_MESSAGE && tags_open);
+		const uint8_t *scan_end = in_tags ? tags_limit : body_limit;
+
+		// While in the middle of a token, the only bytes that can
+		// change the state are the ones that end said token, so
+		// skip directly to the next one of those.
+		switch (current_state) {
+		case IRCMSG_PARSING_TAGS:
+			// When the tags are not looked at, the ';' between
+			// them are of no interest either.
+			iter = IRCMSG_ENGINE_LAZY_TAGS ?
+				ircmsg_find_token_end(iter, scan_end) :
+				ircmsg_find_tag_end(iter, scan_end);
+			break;
+		case IRCMSG_PARSING_PREFIX:
+		case IRCMSG_PARSING_COMMAND:
+		case IRCMSG_PARSING_PARAMS:
+			iter = ircmsg_find_token_end(iter, scan_end);
+			break;
+		case IRCMSG_PARSING_TRAILING_PARAM:
+			iter = ircmsg_find_line_end(iter, scan_end);
+			break;
+		case IRCMSG_SKIPPING_MESSAGE:
+			// Skipped tags still end where they would otherwise,
+			// which is where the limit on the rest starts from.
+			if (!tags_open) {
+				iter = ircmsg_find_line_end(iter, scan_end);
+			} else if (IRCMSG_ENGINE_LAZY_TAGS) {
+				iter = ircmsg_find_token_end(iter, scan_end);
+			} else {
+				iter = ircmsg_find_tag_end(iter, scan_end);
+			}
+			break;
+		default:
+			break;
+		}
+		bytes_consumed = iter - buf;
+		if (iter >= scan_end) {
+			if (scan_end == end) break;
+			IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+			hit_error = true;
+			break;
+		}
+
+		if (current_state == IRCMSG_SKIPPING_MESSAGE && tags_open &&
+		    (*iter == ';' || ircmsg_is_irc_whitespace(*iter))) {
+			if (*iter == ';') {
+				head = iter + 1;
+			} else if (head != iter) {
+				tags_open = false;
+				body_start = iter + 1;
+				body_limit = ircmsg_limit_end(body_start, end, body_max);
+			}
+			continue;
+		}
+
+#if IRCMSG_ENGINE_DFA
+		// Everything that can happen to the byte we stopped at is
+		// looked up from its class and the current state.
+		const uint8_t transition = ircmsg_dfa_table[current_state]
+			[ircmsg_byte_classes[*iter]];
+		const ircmsg_dfa_action action = IRCMSG_DFA_ACTION(transition);
+		switch (action) {
+		case IRCMSG_DFA_NONE:
+			break;
+		case IRCMSG_DFA_SKIP_SPACE:
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_START_TAGS:
+			IRCMSG_ENGINE_START_MESSAGE();
+			message_started = true;
+			tags_open = true;
+			IRCMSG_ENGINE_TAKE_CONTROL();
+			if (IRCMSG_ENGINE_REPORTING()) IRCMSG_ENGINE_START_TAGS();
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_NEXT_TAG:
+			IRCMSG_ENGINE_PARSE_TAG(head, iter);
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_END_TAGS:
+			// A space right after a ';' or the '@' does not end
+			// the tags.
+			if (head == iter) continue;
+			if (IRCMSG_ENGINE_LAZY_TAGS) {
+				IRCMSG_ENGINE_ON_TAG_SECTION(head, iter - head);
+			} else {
+				IRCMSG_ENGINE_PARSE_TAG(head, iter);
+			}
+			head = iter + 1;
+			tags_open = false;
+			body_start = iter + 1;
+			body_limit = ircmsg_limit_end(body_start, end, body_max);
+			break;
+		case IRCMSG_DFA_START_PREFIX:
+			if (!message_started) {
+				IRCMSG_ENGINE_START_MESSAGE();
+				message_started = true;
+			}
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_END_PREFIX:
+			IRCMSG_ENGINE_ON_PREFIX(head, iter - head);
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_START_COMMAND:
+			if (!message_started) {
+				IRCMSG_ENGINE_START_MESSAGE();
+				message_started = true;
+			}
+			head = iter;
+			break;
+		case IRCMSG_DFA_END_COMMAND:
+			IRCMSG_ENGINE_ON_COMMAND(head, iter - head);
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_START_PARAM:
+			head = iter;
+			if (!params_started) {
+				IRCMSG_ENGINE_START_PARAMS();
+				params_started = true;
+			}
+			break;
+		case IRCMSG_DFA_START_TRAILING:
+			if (!params_started) {
+				IRCMSG_ENGINE_START_PARAMS();
+				params_started = true;
+			}
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_END_PARAM:
+			IRCMSG_ENGINE_ON_PARAM(head, iter - head);
+			head = iter + 1;
+			break;
+		case IRCMSG_DFA_TERMINATE: {
+			// Messages may end with CRLF, LFCR, or only one of
+			// them, so consume both bytes of a pair.
+			if (!at_end && *iter == '\r' && iter == end - 1) {
+				// This might be the first half of a CRLF, so
+				// come back to it once we know.
+				break;
+			}
+			size_t terminator_len = 1;
+			if (iter != end - 1 && (iter[1] == '\r' || iter[1] == '\n')) {
+				if (iter[1] == *iter) {
+					IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_INVALID_SENTINEL);
+					hit_error = true;
+					break;
+				}
+				terminator_len = 2;
+			}
+			const uint8_t *const token_end = iter;
+			iter += terminator_len;
+			bytes_consumed += terminator_len;
+			switch (current_state) {
+			case IRCMSG_PARSING_COMMAND:
+				IRCMSG_ENGINE_ON_COMMAND(head, token_end - head);
+				IRCMSG_ENGINE_TAKE_CONTROL();
+				if (IRCMSG_ENGINE_REPORTING()) IRCMSG_ENGINE_END_MESSAGE();
+				finished = true;
+				break;
+			case IRCMSG_PARSING_PARAMS:
+			case IRCMSG_PARSING_TRAILING_PARAM:
+				IRCMSG_ENGINE_ON_PARAM(head, token_end - head);
+				IRCMSG_ENGINE_TAKE_CONTROL();
+				if (IRCMSG_ENGINE_REPORTING()) {
+					IRCMSG_ENGINE_END_PARAMS();
+					IRCMSG_ENGINE_TAKE_CONTROL();
+				}
+				if (IRCMSG_ENGINE_REPORTING()) IRCMSG_ENGINE_END_MESSAGE();
+				finished = true;
+				break;
+			case IRCMSG_SEARCHING_PARAMS:
+				IRCMSG_ENGINE_END_MESSAGE();
+				finished = true;
+				break;
+			case IRCMSG_SKIPPING_MESSAGE:
+				finished = true;
+				break;
+			case IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND:
+				IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND);
+				hit_error = true;
+				break;
+			default:
+				IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+				hit_error = true;
+				break;
+			}
+			break;
+		}
+		case IRCMSG_DFA_UNEXPECTED_END:
+			IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+			hit_error = true;
+			break;
+		}
+
+		// Whatever ended the message, or failed to, the loop is over.
+		if (action >= IRCMSG_DFA_TERMINATE || aborted) break;
+		if (current_state != IRCMSG_SKIPPING_MESSAGE) {
+			current_state = IRCMSG_DFA_NEXT(transition);
+		}
+#else
+		// If we're not on the last parameter of a command,
+		// which may contain whitespaces, jump to the next
+		// character to seek for the next message token.
+		if ((current_state != IRCMSG_PARSING_TRAILING_PARAM) && ircmsg_is_irc_whitespace (*iter)) {
+			// Special consideration is needed if we're currently
+			// parsing something.
+			if (current_state == IRCMSG_PARSING_TAGS) {
+				if (head != iter) {
+					if (IRCMSG_ENGINE_LAZY_TAGS) {
+						IRCMSG_ENGINE_ON_TAG_SECTION(head, iter - head);
+					} else {
+						IRCMSG_ENGINE_PARSE_TAG(head, iter);
+					}
+					head = iter + 1;
+					tags_open = false;
+					body_start = iter + 1;
+					body_limit = ircmsg_limit_end(body_start, end, body_max);
+					current_state = IRCMSG_SEARCHING_PREFIX_COMMAND;
+				}
+			} else if (current_state == IRCMSG_PARSING_PREFIX) {
+				IRCMSG_ENGINE_ON_PREFIX(head, iter - head);
+				head = iter + 1;
+				current_state = IRCMSG_SEARCHING_COMMAND;
+			} else if (current_state == IRCMSG_PARSING_COMMAND) {
+				IRCMSG_ENGINE_ON_COMMAND(head, iter - head);
+				head = iter + 1;
+				current_state = IRCMSG_SEARCHING_PARAMS;
+			} else if (current_state == IRCMSG_PARSING_PARAMS) {
+				IRCMSG_ENGINE_ON_PARAM(head, iter-head);
+				head = iter + 1;
+				current_state = IRCMSG_SEARCHING_PARAMS;
+			} else {
+				head = iter + 1;
+			}
+		}
+
+		// The IRC spec specifies that messages are terminated by
+		// bytes 0x13 followed by 0x10 (CRLF or \r\n). However, the
+		// other party might not be fully spec compliant and might
+		// send either only one of them or first LF and then CR.
+		//
+		// We must be able to cope with all of these situations. In
+		// particular, we want to consume both bytes, if they exist.
+		if (*iter == '\r' || *iter == '\n') {
+			bool was_cr = *iter == '\r';
+			bool was_lf = *iter == '\n';
+			if (current_state == IRCMSG_PARSING_TAGS) {
+				IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+				hit_error = true;
+				break;
+			}
+			if (!at_end && was_cr && iter == end - 1) {
+				// This might be the first half of a CRLF, so
+				// come back to it once we know.
+				break;
+			}
+			if (iter != (buf + buf_size) - 1) {
+				if (was_lf && *(iter + 1) == '\r') {
+					bytes_consumed += 2;
+					iter += 2;
+				        if (current_state >= IRCMSG_PARSING_COMMAND) {
+						switch (current_state) {
+						case IRCMSG_PARSING_COMMAND:
+							IRCMSG_ENGINE_ON_COMMAND(head, iter - head - 2);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							break;
+						case IRCMSG_PARSING_PARAMS:
+						case IRCMSG_PARSING_TRAILING_PARAM:
+							IRCMSG_ENGINE_ON_PARAM(head, iter - head - 2);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							if (IRCMSG_ENGINE_REPORTING()) {
+								IRCMSG_ENGINE_END_PARAMS();
+								IRCMSG_ENGINE_TAKE_CONTROL();
+							}
+							break;
+						case IRCMSG_SEARCHING_PARAMS:
+						case IRCMSG_SKIPPING_MESSAGE:
+							break;
+						default:
+							// Shouldn't happen!
+							break;
+						}
+						if (IRCMSG_ENGINE_REPORTING()) {
+							IRCMSG_ENGINE_END_MESSAGE();
+						}
+						finished = true;
+					} else if (current_state > IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+						hit_error = true;
+						break;
+					} else {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND);
+						hit_error = true;
+					}
+					break;
+				} else if (was_cr && *(iter + 1) == '\n') {
+					bytes_consumed += 2;
+					iter += 2;
+				        if (current_state >= IRCMSG_PARSING_COMMAND) {
+						switch (current_state) {
+						case IRCMSG_PARSING_COMMAND:
+							IRCMSG_ENGINE_ON_COMMAND(head, iter - head - 2);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							break;
+						case IRCMSG_PARSING_PARAMS:
+						case IRCMSG_PARSING_TRAILING_PARAM:
+							IRCMSG_ENGINE_ON_PARAM(head, iter - head - 2);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							if (IRCMSG_ENGINE_REPORTING()) {
+								IRCMSG_ENGINE_END_PARAMS();
+								IRCMSG_ENGINE_TAKE_CONTROL();
+							}
+							break;
+						case IRCMSG_SEARCHING_PARAMS:
+						case IRCMSG_SKIPPING_MESSAGE:
+							break;
+						default:
+							// Shouldn't happen!
+							break;
+						}
+						if (IRCMSG_ENGINE_REPORTING()) {
+							IRCMSG_ENGINE_END_MESSAGE();
+						}
+						finished = true;
+					} else if (current_state > IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+						hit_error = true;
+						break;
+					} else {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND);
+						hit_error = true;
+					}
+					break;
+				} else if (was_lf && *(iter + 1) == '\n') {
+					IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_INVALID_SENTINEL);
+					hit_error = true;
+					break;
+				} else if (was_cr && *(iter + 1) == '\r') {
+					IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_INVALID_SENTINEL);
+					hit_error = true;
+					break;
+				} else {
+					// A lone CR or LF, which is consumed
+					// just like the pairs above.
+					bytes_consumed += 1;
+					iter += 1;
+					if (current_state >= IRCMSG_PARSING_COMMAND) {
+						switch (current_state) {
+						case IRCMSG_PARSING_COMMAND:
+							IRCMSG_ENGINE_ON_COMMAND(head, iter - head - 1);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							break;
+						case IRCMSG_PARSING_PARAMS:
+						case IRCMSG_PARSING_TRAILING_PARAM:
+							IRCMSG_ENGINE_ON_PARAM(head, iter - head - 1);
+							IRCMSG_ENGINE_TAKE_CONTROL();
+							if (IRCMSG_ENGINE_REPORTING()) {
+								IRCMSG_ENGINE_END_PARAMS();
+								IRCMSG_ENGINE_TAKE_CONTROL();
+							}
+							break;
+						case IRCMSG_SEARCHING_PARAMS:
+						case IRCMSG_SKIPPING_MESSAGE:
+							break;
+						default:
+							// Shouldn't happen!
+							break;
+						}
+						if (IRCMSG_ENGINE_REPORTING()) {
+							IRCMSG_ENGINE_END_MESSAGE();
+						}
+						finished = true;
+					} else if (current_state > IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+						hit_error = true;
+						break;
+					} else {
+						IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND);
+						hit_error = true;
+					}
+					break;
+				}
+			} else {
+				// The terminator is the last byte of the buffer,
+				// so it has to be a lone CR or LF.
+				bytes_consumed += 1;
+				iter += 1;
+				if (current_state >= IRCMSG_PARSING_COMMAND) {
+					switch (current_state) {
+					case IRCMSG_PARSING_COMMAND:
+						IRCMSG_ENGINE_ON_COMMAND(head, iter - head - 1);
+						IRCMSG_ENGINE_TAKE_CONTROL();
+						break;
+					case IRCMSG_PARSING_PARAMS:
+						IRCMSG_ENGINE_ON_PARAM(head, iter - head - 1);
+						IRCMSG_ENGINE_TAKE_CONTROL();
+						if (IRCMSG_ENGINE_REPORTING()) {
+							IRCMSG_ENGINE_END_PARAMS();
+							IRCMSG_ENGINE_TAKE_CONTROL();
+						}
+						break;
+					case IRCMSG_PARSING_TRAILING_PARAM:
+						IRCMSG_ENGINE_ON_PARAM(head, iter - head - 1);
+						IRCMSG_ENGINE_TAKE_CONTROL();
+						if (IRCMSG_ENGINE_REPORTING()) {
+							IRCMSG_ENGINE_END_PARAMS();
+							IRCMSG_ENGINE_TAKE_CONTROL();
+						}
+						break;
+					case IRCMSG_SEARCHING_PARAMS:
+					case IRCMSG_SKIPPING_MESSAGE:
+						break;
+					default:
+						// Shouldn't happen!
+						break;
+					}
+					if (IRCMSG_ENGINE_REPORTING()) {
+						IRCMSG_ENGINE_END_MESSAGE();
+					}
+					finished = true;
+					break;
+				} else if (current_state > IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) {
+					IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+					hit_error = true;
+					break;
+				} else {
+					IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND);
+					hit_error = true;
+					break;
+				}
+			}
+		}
+
+		// IRCv3 introduced so-called "tags" to messages. These tags are optional,
+		// but if they are present, the byte to indicate as much is 0x40 '@'.
+		if (*iter == 0x40 && current_state == IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) {
+			current_state = IRCMSG_PARSING_TAGS;
+			IRCMSG_ENGINE_START_MESSAGE();
+			message_started = true;
+			tags_open = true;
+			IRCMSG_ENGINE_TAKE_CONTROL();
+			if (aborted) break;
+			if (IRCMSG_ENGINE_REPORTING()) IRCMSG_ENGINE_START_TAGS();
+			head = iter + 1;
+
+			continue;
+		}
+
+		if (current_state == IRCMSG_PARSING_TAGS) {
+			if (*iter == ';') {
+				IRCMSG_ENGINE_PARSE_TAG(head, iter);
+				head = iter + 1;
+			}
+			continue;
+		}
+
+		// Now comes the prefix.
+		if (*iter == ':' &&
+		    (current_state == IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND ||
+		     current_state == IRCMSG_SEARCHING_PREFIX_COMMAND)) {
+			current_state = IRCMSG_PARSING_PREFIX;
+			if (!message_started) {
+				IRCMSG_ENGINE_START_MESSAGE();
+				message_started = true;
+			}
+			head = iter + 1;
+			continue;
+		}
+
+		// Now comes the command.
+		if (!ircmsg_is_irc_whitespace(*iter) &&
+		    ((current_state == IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND) ||
+		     (current_state == IRCMSG_SEARCHING_PREFIX_COMMAND) ||
+		     (current_state == IRCMSG_SEARCHING_COMMAND))) {
+			if (!message_started) {
+				IRCMSG_ENGINE_START_MESSAGE();
+				message_started = true;
+			}
+			current_state = IRCMSG_PARSING_COMMAND;
+			head = iter;
+			continue;
+		}
+
+		// Now we're at the params.
+		if (current_state == IRCMSG_SEARCHING_PARAMS) {
+			// If we encounter a colon, that means that we have the
+			// trailing argument.
+			if (*iter == ':') {
+				if (!params_started) {
+					IRCMSG_ENGINE_START_PARAMS();
+					params_started = true;
+				}
+
+				head = iter + 1;
+				current_state = IRCMSG_PARSING_TRAILING_PARAM;
+				continue;
+			}
+
+			// Otherwise, if we encounter a non-whitespace,
+			// make it a param.
+			if (!ircmsg_is_irc_whitespace(*iter)) {
+				head = iter;
+				current_state = IRCMSG_PARSING_PARAMS;
+
+				if (!params_started) {
+					IRCMSG_ENGINE_START_PARAMS();
+					params_started = true;
+				}
+
+				continue;
+			}
+		}
+#endif
+	}
+
+	if (aborted) {
+		ircmsg_engine_reset(st);
+		return IRCMSG_PARSE_ABORTED;
+	}
+
+	if (!hit_error && !finished && !at_end) {
+		st->parsing_state = current_state;
+		st->head = head - buf;
+		st->scanned = iter - buf;
+		st->body_start = body_start - buf;
+		st->message_started = message_started;
+		st->params_started = params_started;
+		st->tags_open = tags_open;
+		return IRCMSG_PARSE_NEED_MORE;
+	}
+
+	if ((current_state == IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND && !hit_error) ||
+	    (current_state < IRCMSG_SEARCHING_COMMAND && !hit_error)) {
+		IRCMSG_ENGINE_ON_ERROR(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+		hit_error = true;
+	}
+
+	ircmsg_engine_reset(st);
+	if (hit_error) return IRCMSG_PARSE_ERROR;
+
+	*consumed = bytes_consumed;
+	return IRCMSG_PARSE_DONE;
+}
+
+#undef IRCMSG_ENGINE_PARSE_TAG
+#undef IRCMSG_ENGINE_TAKE_CONTROL
+#undef IRCMSG_ENGINE_REPORTING
+
+#undef IRCMSG_ENGINE_NAME
+#undef IRCMSG_ENGINE_ARGS
+#undef IRCMSG_ENGINE_START_MESSAGE
+#undef IRCMSG_ENGINE_START_TAGS
+#undef IRCMSG_ENGINE_ON_TAG
+#undef IRCMSG_ENGINE_ON_PREFIX
+#undef IRCMSG_ENGINE_ON_COMMAND
+#undef IRCMSG_ENGINE_START_PARAMS
+#undef IRCMSG_ENGINE_ON_PARAM
+#undef IRCMSG_ENGINE_END_PARAMS
+#undef IRCMSG_ENGINE_END_MESSAGE
+#undef IRCMSG_ENGINE_ON_ERROR
+#undef IRCMSG_ENGINE_TAG_FILTER
+#undef IRCMSG_ENGINE_LAZY_TAGS
+#undef IRCMSG_ENGINE_ON_TAG_SECTION
+#undef IRCMSG_ENGINE_CONTROL
+#undef IRCMSG_ENGINE_DFA
+
+#endif /* IRCMSG_ENGINE_NAME */
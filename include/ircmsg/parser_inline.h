@@ -0,0 +1,205 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// A header-only variant of `ircmsg_parse`, specialized at compile time
+// to a fixed set of callbacks, so that the compiler is free to inline
+// them. Define IRCMSG_INLINE_PARSER to the name of the function to
+// generate, and any of the following to the names of the functions to
+// call, before including this header:
+//
+// * IRCMSG_INLINE_START_MESSAGE
+// * IRCMSG_INLINE_START_TAGS
+// * IRCMSG_INLINE_ON_TAG
+// * IRCMSG_INLINE_ON_TAG_SECTION
+// * IRCMSG_INLINE_ON_PREFIX
+// * IRCMSG_INLINE_ON_COMMAND
+// * IRCMSG_INLINE_ON_COMMAND_ID
+// * IRCMSG_INLINE_START_PARAMS
+// * IRCMSG_INLINE_ON_PARAM
+// * IRCMSG_INLINE_END_PARAMS
+// * IRCMSG_INLINE_END_MESSAGE
+// * IRCMSG_INLINE_ON_ERROR
+//
+// Each takes the same arguments as the `ircmsg_parser_callbacks` member
+// of the same name, except for IRCMSG_INLINE_ON_COMMAND_ID, which is
+// called right after IRCMSG_INLINE_ON_COMMAND with
+// (ircmsg_command_id id, void *user_data), see <ircmsg/command.h>, and
+// IRCMSG_INLINE_ON_TAG_SECTION, which takes (const uint8_t *tags,
+// size_t tags_len, void *user_data). If the latter is defined, the tag
+// section is skipped over and given to it whole instead of being split
+// up for IRCMSG_INLINE_ON_TAG, see `ircmsg_tags_find`.
+// Events whose macro is left undefined are dropped.
+//
+// IRCMSG_INLINE_TAG_FILTER may also be defined, to an expression giving
+// a `const ircmsg_tag_filter *` whose tags are the only ones passed to
+// IRCMSG_INLINE_ON_TAG, and IRCMSG_INLINE_LIMITS, to one giving the
+// `const ircmsg_parser_limits *` to use instead of the default ones.
+//
+// This header may be included several times to generate several
+// parsers; all of the above get undefined again at its end.
+
+#ifndef IRCMSG_INLINE_PARSER
+#error "IRCMSG_INLINE_PARSER must be defined before including <ircmsg/parser_inline.h>"
+#endif
+
+#include <ircmsg/parser_engine.h>
+#include <ircmsg/command.h>
+
+#define IRCMSG_ENGINE_ARGS , void *user_data
+
+#ifdef IRCMSG_INLINE_START_MESSAGE
+#define IRCMSG_ENGINE_START_MESSAGE() IRCMSG_INLINE_START_MESSAGE(user_data)
+#else
+#define IRCMSG_ENGINE_START_MESSAGE() ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_START_TAGS
+#define IRCMSG_ENGINE_START_TAGS() IRCMSG_INLINE_START_TAGS(user_data)
+#else
+#define IRCMSG_ENGINE_START_TAGS() ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_TAG
+#define IRCMSG_ENGINE_ON_TAG(tag_name, tag_name_len, tag_val, tag_val_len) \
+	IRCMSG_INLINE_ON_TAG(tag_name, tag_name_len, tag_val, tag_val_len, \
+			     user_data)
+#else
+#define IRCMSG_ENGINE_ON_TAG(tag_name, tag_name_len, tag_val, tag_val_len) \
+	((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_TAG_FILTER
+#define IRCMSG_ENGINE_TAG_FILTER (IRCMSG_INLINE_TAG_FILTER)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_TAG_SECTION
+#define IRCMSG_ENGINE_LAZY_TAGS true
+#define IRCMSG_ENGINE_ON_TAG_SECTION(section, section_len) \
+	IRCMSG_INLINE_ON_TAG_SECTION(section, section_len, user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_PREFIX
+#define IRCMSG_ENGINE_ON_PREFIX(token, token_len) \
+	IRCMSG_INLINE_ON_PREFIX(token, token_len, user_data)
+#else
+#define IRCMSG_ENGINE_ON_PREFIX(token, token_len) ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_COMMAND
+#define IRCMSG_INLINE_ON_COMMAND_STR_(token, token_len) \
+	IRCMSG_INLINE_ON_COMMAND(token, token_len, user_data)
+#else
+#define IRCMSG_INLINE_ON_COMMAND_STR_(token, token_len) ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_COMMAND_ID
+#define IRCMSG_INLINE_ON_COMMAND_ID_(token, token_len) \
+	IRCMSG_INLINE_ON_COMMAND_ID(ircmsg_command_classify(token, token_len), \
+				    user_data)
+#else
+#define IRCMSG_INLINE_ON_COMMAND_ID_(token, token_len) ((void)user_data)
+#endif
+
+#define IRCMSG_ENGINE_ON_COMMAND(token, token_len)		\
+	do {							\
+		IRCMSG_INLINE_ON_COMMAND_STR_(token, token_len);	\
+		IRCMSG_INLINE_ON_COMMAND_ID_(token, token_len);	\
+	} while (false)
+
+#ifdef IRCMSG_INLINE_START_PARAMS
+#define IRCMSG_ENGINE_START_PARAMS() IRCMSG_INLINE_START_PARAMS(user_data)
+#else
+#define IRCMSG_ENGINE_START_PARAMS() ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_PARAM
+#define IRCMSG_ENGINE_ON_PARAM(token, token_len) \
+	IRCMSG_INLINE_ON_PARAM(token, token_len, user_data)
+#else
+#define IRCMSG_ENGINE_ON_PARAM(token, token_len) ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_END_PARAMS
+#define IRCMSG_ENGINE_END_PARAMS() IRCMSG_INLINE_END_PARAMS(user_data)
+#else
+#define IRCMSG_ENGINE_END_PARAMS() ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_END_MESSAGE
+#define IRCMSG_ENGINE_END_MESSAGE() IRCMSG_INLINE_END_MESSAGE(user_data)
+#else
+#define IRCMSG_ENGINE_END_MESSAGE() ((void)user_data)
+#endif
+
+#ifdef IRCMSG_INLINE_ON_ERROR
+#define IRCMSG_ENGINE_ON_ERROR(err) IRCMSG_INLINE_ON_ERROR(err, user_data)
+#else
+#define IRCMSG_ENGINE_ON_ERROR(err) ((void)user_data)
+#endif
+
+// The engine gets a name of its own, derived from the public one, so
+// that the wrapper below can share it.
+#define IRCMSG_INLINE_CONCAT_(a, b) a ## b
+#define IRCMSG_INLINE_CONCAT(a, b) IRCMSG_INLINE_CONCAT_(a, b)
+#define IRCMSG_ENGINE_NAME IRCMSG_INLINE_CONCAT(IRCMSG_INLINE_PARSER, _engine)
+
+#include <ircmsg/parser_engine.h>
+
+// Same as `ircmsg_parse`, but calling the functions named above.
+static inline size_t
+IRCMSG_INLINE_PARSER(const uint8_t *buf, size_t buf_size, void *user_data)
+{
+	ircmsg_parser_state st;
+#ifdef IRCMSG_INLINE_LIMITS
+	ircmsg_engine_init_limits(&st, IRCMSG_INLINE_LIMITS);
+#else
+	ircmsg_engine_init(&st);
+#endif
+
+	size_t consumed = 0;
+	if (IRCMSG_INLINE_CONCAT(IRCMSG_INLINE_PARSER, _engine)(
+		    &st, buf, buf_size, true, &consumed, user_data)
+	    != IRCMSG_PARSE_DONE) {
+		return 0;
+	}
+
+	return consumed;
+}
+
+#undef IRCMSG_INLINE_CONCAT
+#undef IRCMSG_INLINE_CONCAT_
+#undef IRCMSG_INLINE_ON_COMMAND_STR_
+#undef IRCMSG_INLINE_ON_COMMAND_ID_
+
+#undef IRCMSG_INLINE_PARSER
+#undef IRCMSG_INLINE_START_MESSAGE
+#undef IRCMSG_INLINE_START_TAGS
+#undef IRCMSG_INLINE_ON_TAG
+#undef IRCMSG_INLINE_ON_TAG_SECTION
+#undef IRCMSG_INLINE_TAG_FILTER
+#undef IRCMSG_INLINE_LIMITS
+#undef IRCMSG_INLINE_ON_PREFIX
+#undef IRCMSG_INLINE_ON_COMMAND
+#undef IRCMSG_INLINE_ON_COMMAND_ID
+#undef IRCMSG_INLINE_START_PARAMS
+#undef IRCMSG_INLINE_ON_PARAM
+#undef IRCMSG_INLINE_END_PARAMS
+#undef IRCMSG_INLINE_END_MESSAGE
+#undef IRCMSG_INLINE_ON_ERROR
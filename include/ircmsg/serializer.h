@@ -55,6 +55,23 @@ ircmsg_serialize(uint8_t *buf,
 		 const ircmsg_serializer_callbacks *cbs,
 		 void *user_data);
 
+/*
+ * Serializes the message described by `cbs` into `buf`, in range
+ * [`buf`, `buf+buf_size`), calling each callback only once.
+ *
+ * Returns the length of the message, which has been written to `buf`
+ * in full if `truncated` is set to false. Otherwise `buf` is too small
+ * for it, and only holds the pieces of the message that fit, while
+ * the length returned is the size of the buffer it needs, as
+ * `ircmsg_serialize_buffer_len` would have given.
+ */
+size_t
+ircmsg_serialize_checked(uint8_t *buf,
+			 size_t buf_size,
+			 const ircmsg_serializer_callbacks *cbs,
+			 void *user_data,
+			 bool *truncated);
+
 size_t
 ircmsg_serialize_buffer_len(const ircmsg_serializer_callbacks *cbs,
 			    void *user_data);
@@ -0,0 +1,77 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __SERIALIZER_IOV_H_
+#define __SERIALIZER_IOV_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/uio.h>
+#include <ircmsg/serializer.h>
+
+/*
+ * The most iovecs `ircmsg_serialize_iov` needs for a message with
+ * `param_count` params.
+ */
+#define IRCMSG_SERIALIZE_IOV_MAX(param_count) (2 * (param_count) + 5)
+
+/*
+ * Serializes the message described by `cbs` into iovecs, ready to be
+ * passed to writev(2), calling each callback only once.
+ *
+ * Instead of being copied, the prefix, the command and the params
+ * are referenced from where the callbacks point to, so that memory
+ * has to stay put until the iovecs have been written. What the
+ * library adds around them is written to `scratch`, in range
+ * [`scratch`, `scratch+scratch_size`): the tags, which are copied
+ * as they get escaped, and the separators between the rest of the
+ * message. Pieces of the message only a few bytes long are copied to
+ * `scratch` too, if it has room for them, so that they share an iovec
+ * with the separators around them.
+ *
+ * Returns the number of iovecs written to `iov`, and sets `msg_len`
+ * to the length of the message they make up. Returns 0 if the message
+ * needs more than the `iov_cap` iovecs `iov` has room for, which is
+ * never more than `IRCMSG_SERIALIZE_IOV_MAX(param_count)`, or more
+ * scratch space than `scratch_size`, which is never more than the
+ * length of the tags as serialized plus `param_count` + 5 bytes. For
+ * messages within the limits of the parser,
+ * `IRCMSG_PARSER_MAX_TAGS_LEN + IRCMSG_PARSER_MAX_BODY_LEN` bytes is
+ * enough.
+ */
+size_t
+ircmsg_serialize_iov(struct iovec *iov,
+		     size_t iov_cap,
+		     uint8_t *scratch,
+		     size_t scratch_size,
+		     const ircmsg_serializer_callbacks *cbs,
+		     void *user_data,
+		     size_t *msg_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/serializer_iov.h */
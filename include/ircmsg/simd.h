@@ -0,0 +1,80 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __SIMD_H_
+#define __SIMD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdbool.h>
+
+/*
+ * How many bytes at a time the parser looks at while skipping over the
+ * inside of tokens, and the unescaping functions while looking for
+ * escapes. Each level needs the CPU to support the ones before it.
+ */
+typedef enum
+{
+	IRCMSG_SIMD_SCALAR,
+	IRCMSG_SIMD_SSE2,
+	IRCMSG_SIMD_AVX2,
+	IRCMSG_SIMD_AVX512,
+} ircmsg_simd_level;
+
+/*
+ * The level in use.
+ *
+ * When the library is built with the `simd_dispatch` option, which is
+ * the default on x86, this is the highest level the CPU supports,
+ * picked when the library is loaded. The environment variable
+ * IRCMSG_SIMD may be set to "scalar", "sse2", "avx2" or "avx512" to
+ * pick a lower one instead.
+ *
+ * Otherwise, the level is the one the library was compiled for, and
+ * cannot be changed.
+ */
+ircmsg_simd_level
+ircmsg_simd_get_level(void);
+
+/*
+ * Switches to `level`, returning false, and changing nothing, if the
+ * CPU does not support it or the level cannot be changed.
+ *
+ * This may be called while other threads are parsing or unescaping.
+ * Whatever they are in the middle of may finish with the old level,
+ * which gives the same results, only at another speed.
+ */
+bool
+ircmsg_simd_set_level(ircmsg_simd_level level);
+
+/*
+ * The name of `level`, as taken by IRCMSG_SIMD, or NULL if there is
+ * no such level.
+ */
+const char *
+ircmsg_simd_level_name(ircmsg_simd_level level);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/simd.h */
@@ -0,0 +1,114 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#ifndef __STATS_H_
+#define __STATS_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+
+// Counts of 0 to 30 each get a bucket, and the last one has the rest.
+#define IRCMSG_STATS_COUNT_BUCKETS 32
+// Lengths go in power of two buckets, the last one starting at 16384.
+#define IRCMSG_STATS_LENGTH_BUCKETS 16
+
+/*
+ * What the library has parsed and serialized, as counted when it is
+ * built with the `stats` option.
+ *
+ * The parser counts the messages parsed by `ircmsg_parse`,
+ * `ircmsg_parse_batch`, `ircmsg_parse_batch_recover` and
+ * `ircmsg_parse_stream`, along with the errors they report. Only the
+ * tags given to `on_tag` are counted. The histograms are indexed with
+ * `ircmsg_stats_count_bucket` and `ircmsg_stats_length_bucket`.
+ *
+ * The serializer counts the messages written whole by
+ * `ircmsg_serialize`, `ircmsg_serialize_checked` and
+ * `ircmsg_serialize_iov`.
+ */
+typedef struct
+{
+	uint64_t messages;
+	uint64_t bytes;
+	uint64_t errors[IRCMSG_ERR_PARSER_END];
+
+	uint64_t tags_per_message[IRCMSG_STATS_COUNT_BUCKETS];
+	uint64_t params_per_message[IRCMSG_STATS_COUNT_BUCKETS];
+	uint64_t message_lengths[IRCMSG_STATS_LENGTH_BUCKETS];
+	uint64_t tag_lengths[IRCMSG_STATS_LENGTH_BUCKETS];
+	uint64_t param_lengths[IRCMSG_STATS_LENGTH_BUCKETS];
+
+	uint64_t serialized_messages;
+	uint64_t serialized_bytes;
+} ircmsg_stats;
+
+/*
+ * The histogram bucket for `count`.
+ */
+static inline size_t
+ircmsg_stats_count_bucket(size_t count)
+{
+	return count < IRCMSG_STATS_COUNT_BUCKETS - 1 ?
+		count : IRCMSG_STATS_COUNT_BUCKETS - 1;
+}
+
+/*
+ * The histogram bucket for `len`: 0 for 0, and otherwise `n` for
+ * lengths in range [2^(`n`-1), 2^`n`).
+ */
+static inline size_t
+ircmsg_stats_length_bucket(size_t len)
+{
+	size_t bucket = 0;
+	while (len != 0 && bucket < IRCMSG_STATS_LENGTH_BUCKETS - 1) {
+		len >>= 1;
+		++bucket;
+	}
+	return bucket;
+}
+
+/*
+ * Copies the counters to `stats`. Each counter is read on its own, so
+ * counters being updated by other threads at the same time may be a
+ * message apart.
+ *
+ * Returns false, with every counter 0, if the library was built without
+ * the `stats` option.
+ */
+bool
+ircmsg_stats_snapshot(ircmsg_stats *stats);
+
+/*
+ * Sets every counter back to 0.
+ */
+void
+ircmsg_stats_reset(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ircmsg/stats.h */
@@ -0,0 +1,78 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/command.h"
+#include <stdbool.h>
+
+struct command_name
+{
+	uint8_t len;
+	char name[16];
+};
+
+#include "command_table.h"
+
+// Must match command_hash in command_table.py.
+static inline uint32_t
+command_hash(const uint8_t *command, size_t command_len)
+{
+	uint32_t hash = COMMAND_HASH_SEED;
+	for (size_t i = 0; i < command_len; ++i) {
+		hash = (hash ^ (command[i] & 0xDF)) * 0x01000193u;
+	}
+	return hash >> (32 - COMMAND_HASH_BITS);
+}
+
+static inline bool
+is_digit(uint8_t byte)
+{
+	return byte >= '0' && byte <= '9';
+}
+
+ircmsg_command_id
+ircmsg_command_classify(const uint8_t *command, size_t command_len)
+{
+	if (command_len == 3 && is_digit(command[0]) &&
+	    is_digit(command[1]) && is_digit(command[2])) {
+		return (ircmsg_command_id) ((command[0] - '0') * 100 +
+					    (command[1] - '0') * 10 +
+					    (command[2] - '0'));
+	}
+
+	if (command_len == 0 || command_len > COMMAND_NAME_MAX) {
+		return IRCMSG_CMD_UNKNOWN;
+	}
+
+	uint8_t idx = command_slots[command_hash(command, command_len)];
+	const struct command_name *candidate = &command_names[idx];
+	if (idx == 0 || candidate->len != command_len) {
+		return IRCMSG_CMD_UNKNOWN;
+	}
+
+	// The names are all upper-case letters, so clearing the case
+	// bit is enough to compare case-insensitively.
+	for (size_t i = 0; i < command_len; ++i) {
+		if ((command[i] & 0xDF) != (uint8_t) candidate->name[i]) {
+			return IRCMSG_CMD_UNKNOWN;
+		}
+	}
+
+	return (ircmsg_command_id) (IRCMSG_CMD_UNKNOWN + idx);
+}
@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Jani Juhani Sinervo
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+# Generates the perfect hash table used by ircmsg_command_classify from the
+# named commands in ircmsg/command.h.
+#
+# The hash is FNV-1a over the upper-cased command, and the seed is
+# searched for so that no two commands land in the same slot. It must
+# match command_hash in command.c.
+
+import re
+import sys
+
+TABLE_BITS = 9
+TABLE_SIZE = 1 << TABLE_BITS
+FNV_PRIME = 0x01000193
+
+def command_hash(seed, name):
+    h = seed
+    for c in name.encode('ascii'):
+        h = ((h ^ (c & 0xDF)) * FNV_PRIME) & 0xFFFFFFFF
+    return h >> (32 - TABLE_BITS)
+
+def find_seed(names):
+    for seed in range(1, 1 << 24):
+        slots = set()
+        for name in names:
+            slot = command_hash(seed, name)
+            if slot in slots:
+                break
+            slots.add(slot)
+        else:
+            return seed
+    raise RuntimeError('no perfect hash seed found')
+
+header, output = sys.argv[1], sys.argv[2]
+
+with open(header, 'r') as f:
+    enum = f.read()
+    enum = enum[enum.index('IRCMSG_CMD_UNKNOWN'):enum.index('IRCMSG_CMD_END')]
+    names = re.findall(r'^\s*IRCMSG_CMD_([A-Z]+),', enum, re.MULTILINE)
+
+seed = find_seed(names)
+slots = [0] * TABLE_SIZE
+for idx, name in enumerate(names):
+    # 0 marks an empty slot, so the first command is 1, just like its
+    # offset from IRCMSG_CMD_UNKNOWN.
+    slots[command_hash(seed, name)] = idx + 1
+
+with open(output, 'w') as f:
+    f.write('// Generated by command_table.py, do not edit.\n\n')
+    f.write('#define COMMAND_HASH_SEED {}u\n'.format(hex(seed)))
+    f.write('#define COMMAND_HASH_BITS {}\n'.format(TABLE_BITS))
+    f.write('#define COMMAND_NAME_MAX {}\n\n'.format(max(map(len, names))))
+
+    f.write('static const uint8_t command_slots[{}] = {{\n'.format(TABLE_SIZE))
+    for i in range(0, TABLE_SIZE, 16):
+        f.write('\t' + ', '.join(str(s) for s in slots[i:i + 16]) + ',\n')
+    f.write('};\n\n')
+
+    f.write('static const struct command_name command_names[] = {\n')
+    f.write('\t{ 0, "" },\n')
+    for name in names:
+        f.write('\t{{ {}, "{}" }},\n'.format(len(name), name))
+    f.write('};\n')
@@ -0,0 +1,91 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/dispatch.h"
+#include "ircmsg/parser_engine.h"
+
+static inline void
+dispatch_view(const ircmsg_dispatch_table *table,
+	      const uint8_t *buf,
+	      const ircmsg_message_view *view,
+	      void *user_data)
+{
+	// A single load, as the command ID is in range by construction.
+	ircmsg_handler handler = table->handlers[view->command_id];
+	if (handler == NULL) handler = table->fallback;
+	if (handler != NULL) handler(buf, view, user_data);
+}
+
+size_t
+ircmsg_dispatch(const ircmsg_dispatch_table *table,
+		const uint8_t *buf,
+		size_t buf_size,
+		ircmsg_message_view *view,
+		void *user_data)
+{
+	return ircmsg_dispatch_ex(table, buf, buf_size, view, user_data, NULL);
+}
+
+size_t
+ircmsg_dispatch_ex(const ircmsg_dispatch_table *table,
+		   const uint8_t *buf,
+		   size_t buf_size,
+		   ircmsg_message_view *view,
+		   void *user_data,
+		   const ircmsg_parser_limits *limits)
+{
+	size_t consumed = ircmsg_parse_to_view_ex(buf, buf_size, view, limits);
+	if (consumed != 0) dispatch_view(table, buf, view, user_data);
+	return consumed;
+}
+
+size_t
+ircmsg_dispatch_batch(const ircmsg_dispatch_table *table,
+		      const uint8_t *buf,
+		      size_t buf_size,
+		      ircmsg_message_view *view,
+		      void *user_data)
+{
+	return ircmsg_dispatch_batch_ex(table, buf, buf_size, view, user_data,
+					NULL);
+}
+
+size_t
+ircmsg_dispatch_batch_ex(const ircmsg_dispatch_table *table,
+			 const uint8_t *buf,
+			 size_t buf_size,
+			 ircmsg_message_view *view,
+			 void *user_data,
+			 const ircmsg_parser_limits *limits)
+{
+	const uint8_t *complete_end = ircmsg_find_complete_end(buf, buf + buf_size);
+
+	const uint8_t *iter = buf;
+	while (iter < complete_end) {
+		size_t consumed = ircmsg_parse_to_view_ex(iter, complete_end - iter,
+							  view, limits);
+		if (consumed == 0) break;
+
+		dispatch_view(table, iter, view, user_data);
+		iter += consumed;
+	}
+
+	return iter - buf;
+}
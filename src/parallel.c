@@ -0,0 +1,344 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/parallel.h"
+#include "ircmsg/parser_engine.h"
+#include <pthread.h>
+
+// The parser, also counting the messages it has seen.
+#define IRCMSG_ENGINE_NAME parse_counted
+#define IRCMSG_ENGINE_ARGS , const ircmsg_parser_callbacks *cbs, void *user_data, size_t *message_count
+#define IRCMSG_ENGINE_START_MESSAGE() cbs->start_message(user_data)
+#define IRCMSG_ENGINE_START_TAGS() cbs->start_tags(user_data)
+#define IRCMSG_ENGINE_ON_TAG(name, name_len, value, value_len) \
+	cbs->on_tag((name), (name_len), (value), (value_len), user_data)
+#define IRCMSG_ENGINE_ON_PREFIX(prefix, len) cbs->on_prefix((prefix), (len), user_data)
+#define IRCMSG_ENGINE_ON_COMMAND(command, len) cbs->on_command((command), (len), user_data)
+#define IRCMSG_ENGINE_START_PARAMS() cbs->start_params(user_data)
+#define IRCMSG_ENGINE_ON_PARAM(param, len) cbs->on_param((param), (len), user_data)
+#define IRCMSG_ENGINE_END_PARAMS() cbs->end_params(user_data)
+#define IRCMSG_ENGINE_END_MESSAGE()					\
+	do {								\
+		cbs->end_message(user_data);				\
+		++*message_count;					\
+	} while (false)
+#define IRCMSG_ENGINE_ON_ERROR(error) cbs->on_error((error), user_data)
+#include "ircmsg/parser_engine.h"
+
+static inline bool
+is_terminator(uint8_t byte)
+{
+	return byte == '\r' || byte == '\n';
+}
+
+// Finds the first message boundary at or after `iter`: the end of the
+// first run of terminators in [iter, end) that directly follows
+// something else. Since that something else belongs to a message, the
+// parser ends said message right there, no matter where it started.
+// The whole run stays with said message, as it is how the run starts
+// that decides whether it's a CRLF, or a CRCR or LFLF that the parser
+// rejects, and the chunk after it has to start where a batch would be
+// after the run.
+static const uint8_t *
+find_boundary(const uint8_t *buf, const uint8_t *iter, const uint8_t *end)
+{
+	if (iter == buf) return buf;
+
+	const uint8_t *term = ircmsg_find_line_end(iter, end);
+	while (term < end && is_terminator(*(term - 1))) {
+		const uint8_t *run_end = term;
+		while (run_end < end && is_terminator(*run_end)) ++run_end;
+		term = ircmsg_find_line_end(run_end, end);
+	}
+	while (term < end && is_terminator(*term)) ++term;
+	return term;
+}
+
+static void
+parse_chunk(const uint8_t *buf,
+	    const ircmsg_parser_callbacks *cbs,
+	    void *user_data,
+	    const ircmsg_parser_limits *limits,
+	    ircmsg_parallel_chunk *chunk)
+{
+	const uint8_t *const start = buf + chunk->offset;
+	const uint8_t *const end = start + chunk->len;
+
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	const uint8_t *iter = start;
+	while (iter < end) {
+		size_t consumed = 0;
+		if (parse_counted(&st, iter, end - iter, true, &consumed,
+				  cbs, user_data,
+				  &chunk->message_count) != IRCMSG_PARSE_DONE) {
+			chunk->failed = true;
+			break;
+		}
+		iter += consumed;
+	}
+	chunk->consumed = iter - start;
+}
+
+// Takes chunks of the buffer being parsed and parses them, until
+// there are none left. Called with the pool locked, and returns with
+// it locked.
+static void
+take_chunks(ircmsg_parallel_pool *pool)
+{
+	while (pool->next_chunk < pool->chunk_count) {
+		size_t i = pool->next_chunk++;
+		pthread_mutex_unlock(&pool->lock);
+		parse_chunk(pool->buf, pool->cbs, pool->user_data[i],
+			    pool->limits, &pool->chunks[i]);
+		pthread_mutex_lock(&pool->lock);
+		if (++pool->chunks_done == pool->chunk_count) {
+			pthread_cond_signal(&pool->work_done);
+		}
+	}
+}
+
+static void *
+pool_worker(void *arg)
+{
+	ircmsg_parallel_pool *pool = arg;
+	unsigned long seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+	for (;;) {
+		while (!pool->stopping && pool->generation == seen) {
+			pthread_cond_wait(&pool->work_ready, &pool->lock);
+		}
+		if (pool->stopping) break;
+		seen = pool->generation;
+		take_chunks(pool);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+bool
+ircmsg_parallel_pool_init(ircmsg_parallel_pool *pool, size_t thread_count)
+{
+	if (thread_count > IRCMSG_PARALLEL_MAX_THREADS) return false;
+
+	if (pthread_mutex_init(&pool->lock, NULL) != 0) return false;
+	if (pthread_cond_init(&pool->work_ready, NULL) != 0) {
+		pthread_mutex_destroy(&pool->lock);
+		return false;
+	}
+	if (pthread_cond_init(&pool->work_done, NULL) != 0) {
+		pthread_cond_destroy(&pool->work_ready);
+		pthread_mutex_destroy(&pool->lock);
+		return false;
+	}
+	pool->generation = 0;
+	pool->stopping = false;
+	pool->chunk_count = 0;
+	pool->next_chunk = 0;
+	pool->chunks_done = 0;
+
+	pool->thread_count = 0;
+	while (pool->thread_count < thread_count &&
+	       pthread_create(&pool->threads[pool->thread_count], NULL,
+			      pool_worker, pool) == 0) {
+		++pool->thread_count;
+	}
+
+	return true;
+}
+
+void
+ircmsg_parallel_pool_destroy(ircmsg_parallel_pool *pool)
+{
+	pthread_mutex_lock(&pool->lock);
+	pool->stopping = true;
+	pthread_cond_broadcast(&pool->work_ready);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (size_t i = 0; i < pool->thread_count; ++i) {
+		pthread_join(pool->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool->work_done);
+	pthread_cond_destroy(&pool->work_ready);
+	pthread_mutex_destroy(&pool->lock);
+}
+
+// Splits the complete messages of `buf` into `chunk_count` chunks of
+// about the same size. Returns the length of said messages.
+static size_t
+split_chunks(const uint8_t *buf,
+	     size_t buf_size,
+	     ircmsg_parallel_chunk *chunks,
+	     size_t chunk_count)
+{
+	// Only whole messages are parsed, just like in a batch.
+	const uint8_t *const complete_end =
+		ircmsg_find_complete_end(buf, buf + buf_size);
+	size_t complete_size = complete_end - buf;
+
+	const uint8_t *chunk_start = buf;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		const uint8_t *chunk_end = complete_end;
+		if (i + 1 < chunk_count) {
+			const uint8_t *target =
+				buf + complete_size / chunk_count * (i + 1);
+			if (target < chunk_start) target = chunk_start;
+			chunk_end = find_boundary(buf, target, complete_end);
+		}
+
+		chunks[i].offset = chunk_start - buf;
+		chunks[i].len = chunk_end - chunk_start;
+		chunks[i].first_message = 0;
+		chunks[i].message_count = 0;
+		chunks[i].consumed = 0;
+		chunks[i].failed = false;
+		chunk_start = chunk_end;
+	}
+
+	return complete_size;
+}
+
+// Numbers the messages of the parsed chunks, and returns the bytes
+// consumed up to the first error.
+static size_t
+tally_chunks(ircmsg_parallel_chunk *chunks,
+	     size_t chunk_count,
+	     size_t complete_size)
+{
+	size_t consumed = complete_size;
+	size_t message_count = 0;
+	bool failed = false;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		chunks[i].first_message = message_count;
+		message_count += chunks[i].message_count;
+		if (chunks[i].failed && !failed) {
+			consumed = chunks[i].offset + chunks[i].consumed;
+			failed = true;
+		}
+	}
+
+	return consumed;
+}
+
+size_t
+ircmsg_parse_parallel_pool(ircmsg_parallel_pool *pool,
+			   const uint8_t *buf,
+			   size_t buf_size,
+			   const ircmsg_parser_callbacks *cbs,
+			   void *const *user_data,
+			   ircmsg_parallel_chunk *chunks,
+			   size_t chunk_count)
+{
+	return ircmsg_parse_parallel_pool_ex(pool, buf, buf_size, cbs,
+					     user_data, chunks, chunk_count,
+					     NULL);
+}
+
+size_t
+ircmsg_parse_parallel_pool_ex(ircmsg_parallel_pool *pool,
+			      const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_callbacks *cbs,
+			      void *const *user_data,
+			      ircmsg_parallel_chunk *chunks,
+			      size_t chunk_count,
+			      const ircmsg_parser_limits *limits)
+{
+	if (chunk_count == 0) return 0;
+
+	size_t complete_size = split_chunks(buf, buf_size, chunks,
+					    chunk_count);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->buf = buf;
+	pool->cbs = cbs;
+	pool->user_data = user_data;
+	pool->limits = limits;
+	pool->chunks = chunks;
+	pool->chunk_count = chunk_count;
+	pool->next_chunk = 0;
+	pool->chunks_done = 0;
+	++pool->generation;
+	pthread_cond_broadcast(&pool->work_ready);
+
+	take_chunks(pool);
+	while (pool->chunks_done < pool->chunk_count) {
+		pthread_cond_wait(&pool->work_done, &pool->lock);
+	}
+	pool->chunk_count = 0;
+	pthread_mutex_unlock(&pool->lock);
+
+	return tally_chunks(chunks, chunk_count, complete_size);
+}
+
+size_t
+ircmsg_parse_parallel(const uint8_t *buf,
+		      size_t buf_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      void *const *user_data,
+		      ircmsg_parallel_chunk *chunks,
+		      size_t chunk_count)
+{
+	return ircmsg_parse_parallel_ex(buf, buf_size, cbs, user_data, chunks,
+					chunk_count, NULL);
+}
+
+size_t
+ircmsg_parse_parallel_ex(const uint8_t *buf,
+			 size_t buf_size,
+			 const ircmsg_parser_callbacks *cbs,
+			 void *const *user_data,
+			 ircmsg_parallel_chunk *chunks,
+			 size_t chunk_count,
+			 const ircmsg_parser_limits *limits)
+{
+	if (chunk_count == 0) return 0;
+
+	// The calling thread parses chunks too, so one thread fewer than
+	// there are chunks is enough.
+	size_t thread_count = chunk_count - 1;
+	if (thread_count > IRCMSG_PARALLEL_MAX_THREADS) {
+		thread_count = IRCMSG_PARALLEL_MAX_THREADS;
+	}
+
+	ircmsg_parallel_pool pool;
+	if (ircmsg_parallel_pool_init(&pool, thread_count)) {
+		size_t consumed = ircmsg_parse_parallel_pool_ex(&pool, buf,
+								buf_size, cbs,
+								user_data,
+								chunks,
+								chunk_count,
+								limits);
+		ircmsg_parallel_pool_destroy(&pool);
+		return consumed;
+	}
+
+	// Without a pool, everything is parsed on the calling thread.
+	size_t complete_size = split_chunks(buf, buf_size, chunks,
+					    chunk_count);
+	for (size_t i = 0; i < chunk_count; ++i) {
+		parse_chunk(buf, cbs, user_data[i], limits, &chunks[i]);
+	}
+	return tally_chunks(chunks, chunk_count, complete_size);
+}
@@ -18,73 +18,286 @@
 //  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
 //  DEALINGS IN THE SOFTWARE.
 
-#include "ircmsg/parser.h"
-#include <stdbool.h>
+#include "ircmsg/parser_engine.h"
+#include "stats_counters.h"
+
+// The parser proper, reporting everything through the user's
+// callbacks. When built with the `stats` option, it also counts what
+// it parses, which is where the message ends for `end_message`.
+#define IRCMSG_ENGINE_NAME parse_message
+#define IRCMSG_ENGINE_ARGS , const ircmsg_parser_callbacks *cbs, void *user_data
+#define IRCMSG_ENGINE_TAG_FILTER st->tag_filter
+#define IRCMSG_ENGINE_START_MESSAGE()						\
+	(IRCMSG_STATS_START_MESSAGE(st), cbs->start_message(user_data))
+#define IRCMSG_ENGINE_START_TAGS() cbs->start_tags(user_data)
+#define IRCMSG_ENGINE_ON_TAG(name, name_len, value, value_len)			\
+	(IRCMSG_STATS_TAG(st, (name_len), (value_len)),			\
+	 cbs->on_tag((name), (name_len), (value), (value_len), user_data))
+#define IRCMSG_ENGINE_ON_PREFIX(prefix, len) cbs->on_prefix((prefix), (len), user_data)
+#define IRCMSG_ENGINE_ON_COMMAND(command, len) cbs->on_command((command), (len), user_data)
+#define IRCMSG_ENGINE_START_PARAMS() cbs->start_params(user_data)
+#define IRCMSG_ENGINE_ON_PARAM(param, len)					\
+	(IRCMSG_STATS_PARAM(st, (len)), cbs->on_param((param), (len), user_data))
+#define IRCMSG_ENGINE_END_PARAMS() cbs->end_params(user_data)
+#define IRCMSG_ENGINE_END_MESSAGE()						\
+	(IRCMSG_STATS_END_MESSAGE(st, iter - buf), cbs->end_message(user_data))
+#define IRCMSG_ENGINE_ON_ERROR(error)						\
+	(IRCMSG_STATS_ERROR(error), cbs->on_error((error), user_data))
+#include "ircmsg/parser_engine.h"
+
+// The same, also noting down the error, if any.
+#define IRCMSG_ENGINE_NAME parse_message_noting_error
+#define IRCMSG_ENGINE_ARGS , const ircmsg_parser_callbacks *cbs, void *user_data, ircmsg_parser_err_code *error_out
+#define IRCMSG_ENGINE_START_MESSAGE()						\
+	(IRCMSG_STATS_START_MESSAGE(st), cbs->start_message(user_data))
+#define IRCMSG_ENGINE_START_TAGS() cbs->start_tags(user_data)
+#define IRCMSG_ENGINE_ON_TAG(name, name_len, value, value_len)			\
+	(IRCMSG_STATS_TAG(st, (name_len), (value_len)),			\
+	 cbs->on_tag((name), (name_len), (value), (value_len), user_data))
+#define IRCMSG_ENGINE_ON_PREFIX(prefix, len) cbs->on_prefix((prefix), (len), user_data)
+#define IRCMSG_ENGINE_ON_COMMAND(command, len) cbs->on_command((command), (len), user_data)
+#define IRCMSG_ENGINE_START_PARAMS() cbs->start_params(user_data)
+#define IRCMSG_ENGINE_ON_PARAM(param, len)					\
+	(IRCMSG_STATS_PARAM(st, (len)), cbs->on_param((param), (len), user_data))
+#define IRCMSG_ENGINE_END_PARAMS() cbs->end_params(user_data)
+#define IRCMSG_ENGINE_END_MESSAGE()						\
+	(IRCMSG_STATS_END_MESSAGE(st, iter - buf), cbs->end_message(user_data))
+#define IRCMSG_ENGINE_ON_ERROR(error)						\
+	do {								\
+		*error_out = (error);					\
+		IRCMSG_STATS_ERROR(error);				\
+		cbs->on_error((error), user_data);			\
+	} while (false)
+#include "ircmsg/parser_engine.h"
+
+// The same, but only noting down where everything is in a view.
+static inline void
+view_add_span(ircmsg_span *spans, size_t cap, size_t *count,
+	      const uint8_t *buf, const uint8_t *ptr, size_t len)
+{
+	if (*count < cap) {
+		spans[*count].offset = ptr - buf;
+		spans[*count].len = len;
+	}
+	++*count;
+}
 
-static bool
-is_irc_whitespace(uint8_t byte)
+static inline void
+shift_span(ircmsg_span *span, size_t by)
 {
-	// TODO: Add more byte "characters" that could be considered
-	// whitespace.
-        switch (byte)
-	{
-	case 0x20: // ASCII space
-		return true;
-	default:
+	if (span->len != 0) span->offset += by;
+}
+
+static inline void
+view_split_prefix(ircmsg_message_view *view, const uint8_t *buf,
+		  const uint8_t *prefix, size_t prefix_len)
+{
+	ircmsg_prefix_parts *parts = &view->prefix_parts;
+	ircmsg_prefix_split(prefix, prefix_len, parts);
+	shift_span(&parts->name, prefix - buf);
+	shift_span(&parts->user, prefix - buf);
+	shift_span(&parts->host, prefix - buf);
+}
+
+#define IRCMSG_ENGINE_NAME parse_message_to_view
+#define IRCMSG_ENGINE_ARGS , ircmsg_message_view *view
+#define IRCMSG_ENGINE_START_MESSAGE() ((void) 0)
+#define IRCMSG_ENGINE_START_TAGS() ((void) 0)
+#define IRCMSG_ENGINE_ON_TAG(tag_name, tag_name_len, tag_val, tag_val_len)			\
+	do {								\
+		if (view->tag_count < view->tags_cap) {			\
+			ircmsg_tag_span *tag_span =			\
+				&view->tags[view->tag_count];		\
+			tag_span->name.offset = (tag_name) - buf;		\
+			tag_span->name.len = (tag_name_len);		\
+			tag_span->value.offset =			\
+				(tag_val) != NULL ? (tag_val) - buf : 0;	\
+			tag_span->value.len = (tag_val_len);		\
+		}							\
+		++view->tag_count;					\
+	} while (false)
+#define IRCMSG_ENGINE_TAG_FILTER view->tag_filter
+#define IRCMSG_ENGINE_LAZY_TAGS view->lazy_tags
+#define IRCMSG_ENGINE_ON_TAG_SECTION(section, section_len)		\
+	do {								\
+		view->tag_section.offset = (section) - buf;		\
+		view->tag_section.len = (section_len);			\
+	} while (false)
+#define IRCMSG_ENGINE_ON_PREFIX(token, token_len)					\
+	do {								\
+		view->has_prefix = true;				\
+		view->prefix.offset = (token) - buf;			\
+		view->prefix.len = (token_len);				\
+		view_split_prefix(view, buf, (token), (token_len));	\
+	} while (false)
+#define IRCMSG_ENGINE_ON_COMMAND(token, token_len)					\
+	do {								\
+		view->command.offset = (token) - buf;			\
+		view->command.len = (token_len);				\
+		view->command_id =					\
+			ircmsg_command_classify((token), (token_len));	\
+	} while (false)
+#define IRCMSG_ENGINE_START_PARAMS() ((void) 0)
+#define IRCMSG_ENGINE_ON_PARAM(token, token_len)					\
+	view_add_span(view->params, view->params_cap,			\
+		      &view->param_count, buf, (token), (token_len))
+#define IRCMSG_ENGINE_END_PARAMS() ((void) 0)
+#define IRCMSG_ENGINE_END_MESSAGE() ((void) 0)
+#define IRCMSG_ENGINE_ON_ERROR(err) (view->error = (err))
+#include "ircmsg/parser_engine.h"
+
+// The part of a token that was at the end of the first of two
+// segments, which the first token found in the second segment
+// continues.
+struct seam
+{
+	const uint8_t *second;
+	const uint8_t *first_part;
+	size_t first_part_len;
+	bool pending;
+	ircmsg_split_token_cb on_split_token;
+};
+
+// Whether the token in [token, token+token_len) was split in two and
+// has been reported as such. If all of it was in the first segment
+// after all, it is swapped for that part instead.
+static inline bool
+seam_split(struct seam *seam, ircmsg_split_kind kind,
+	   const uint8_t **token, size_t *token_len, void *user_data)
+{
+	if (!seam->pending || *token != seam->second) return false;
+
+	seam->pending = false;
+	if (*token_len == 0) {
+		*token = seam->first_part;
+		*token_len = seam->first_part_len;
 		return false;
 	}
+
+	seam->on_split_token(kind, seam->first_part, seam->first_part_len,
+			     *token, *token_len, user_data);
+	return true;
 }
 
-static void
-parse_tag(const uint8_t *head,
-	  const uint8_t *tail,
-	  const ircmsg_parser_callbacks *cbs,
-	  void *user_data)
+static inline void
+seam_on_token(struct seam *seam, ircmsg_split_kind kind,
+	      void (*const on_token)(const uint8_t *, size_t, void *),
+	      const uint8_t *token, size_t token_len, void *user_data)
 {
-	const uint8_t *name_head = head;
-	size_t name_len = 0;
+	if (!seam_split(seam, kind, &token, &token_len, user_data)) {
+		on_token(token, token_len, user_data);
+	}
+}
 
-	const uint8_t *value_head = NULL;
-        size_t value_len = 0;
+static inline void
+seam_on_tag(struct seam *seam, const ircmsg_parser_callbacks *cbs,
+	    const uint8_t *head, const uint8_t *tail, void *user_data)
+{
+	size_t len = tail - head;
+	if (seam_split(seam, IRCMSG_SPLIT_TAG, &head, &len, user_data)) return;
+
+	size_t name_len;
+	const uint8_t *value;
+	size_t value_len;
+	ircmsg_split_tag(head, head + len, &name_len, &value, &value_len);
+	cbs->on_tag(head, name_len, value, value_len, user_data);
+}
 
-	const uint8_t *iter;
-	for (iter = head; iter < tail; ++iter) {
-		// Values are split from names with 0x3D '='.
-		if (*iter == 0x3D) {
-			name_len = iter - name_head;
-			value_head = iter + 1;
-		}
-	}
+// The parser, for a message that started in the previous segment.
+#define IRCMSG_ENGINE_NAME parse_message_seam
+#define IRCMSG_ENGINE_ARGS , const ircmsg_parser_callbacks *cbs, void *user_data, struct seam *seam
+#define IRCMSG_ENGINE_START_MESSAGE() cbs->start_message(user_data)
+#define IRCMSG_ENGINE_START_TAGS() cbs->start_tags(user_data)
+#define IRCMSG_ENGINE_PARSE_TAG(tag_head, tag_tail)				\
+	seam_on_tag(seam, cbs, (tag_head), (tag_tail), user_data)
+#define IRCMSG_ENGINE_ON_TAG(name, name_len, value, value_len) ((void) 0)
+#define IRCMSG_ENGINE_ON_PREFIX(prefix, len)					\
+	seam_on_token(seam, IRCMSG_SPLIT_PREFIX, cbs->on_prefix,		\
+		      (prefix), (len), user_data)
+#define IRCMSG_ENGINE_ON_COMMAND(command, len)					\
+	seam_on_token(seam, IRCMSG_SPLIT_COMMAND, cbs->on_command,		\
+		      (command), (len), user_data)
+#define IRCMSG_ENGINE_START_PARAMS() cbs->start_params(user_data)
+#define IRCMSG_ENGINE_ON_PARAM(param, len)					\
+	seam_on_token(seam, IRCMSG_SPLIT_PARAM, cbs->on_param,		\
+		      (param), (len), user_data)
+#define IRCMSG_ENGINE_END_PARAMS() cbs->end_params(user_data)
+#define IRCMSG_ENGINE_END_MESSAGE() cbs->end_message(user_data)
+#define IRCMSG_ENGINE_ON_ERROR(error) cbs->on_error((error), user_data)
+#include "ircmsg/parser_engine.h"
+
+// Keeps the strongest of the controls asked for since the parser last
+// looked, so that e.g. a skip is not undone by a later continue.
+static inline void
+control_update(ircmsg_parser_control *control, ircmsg_parser_control next)
+{
+	if (next > *control) *control = next;
+}
 
-	if (name_len == 0) name_len = iter - name_head;
+static inline ircmsg_parser_control
+control_take(ircmsg_parser_control *control)
+{
+	ircmsg_parser_control taken = *control;
+	*control = IRCMSG_PARSER_CONTINUE;
+	return taken;
+}
+
+// The parser, for callbacks that tell it how to go on.
+#define CONTROL_CALL(callback, ...)						\
+	(cbs->callback ?						\
+	 control_update(asked, cbs->callback(__VA_ARGS__)) : (void) 0)
+#define IRCMSG_ENGINE_NAME parse_message_controlled
+#define IRCMSG_ENGINE_ARGS , const ircmsg_parser_control_callbacks *cbs, void *user_data, ircmsg_parser_control *asked
+#define IRCMSG_ENGINE_CONTROL() control_take(asked)
+#define IRCMSG_ENGINE_START_MESSAGE() CONTROL_CALL(start_message, user_data)
+#define IRCMSG_ENGINE_START_TAGS() CONTROL_CALL(start_tags, user_data)
+#define IRCMSG_ENGINE_ON_TAG(name, name_len, value, value_len)			\
+	CONTROL_CALL(on_tag, (name), (name_len), (value), (value_len), user_data)
+#define IRCMSG_ENGINE_ON_PREFIX(prefix, len)					\
+	CONTROL_CALL(on_prefix, (prefix), (len), user_data)
+#define IRCMSG_ENGINE_ON_COMMAND(command, len)					\
+	CONTROL_CALL(on_command, (command), (len), user_data)
+#define IRCMSG_ENGINE_START_PARAMS() CONTROL_CALL(start_params, user_data)
+#define IRCMSG_ENGINE_ON_PARAM(param, len)					\
+	CONTROL_CALL(on_param, (param), (len), user_data)
+#define IRCMSG_ENGINE_END_PARAMS() CONTROL_CALL(end_params, user_data)
+#define IRCMSG_ENGINE_END_MESSAGE() CONTROL_CALL(end_message, user_data)
+#define IRCMSG_ENGINE_ON_ERROR(error)						\
+	(cbs->on_error ? cbs->on_error((error), user_data) : (void) 0)
+#include "ircmsg/parser_engine.h"
+#undef CONTROL_CALL
+
+void
+ircmsg_parser_state_init(ircmsg_parser_state *state)
+{
+	ircmsg_engine_init(state);
+}
 
-	if (value_head != NULL) {
-		value_len = iter - value_head;
+bool
+ircmsg_tag_filter_init(ircmsg_tag_filter *filter,
+		       const char *const *names,
+		       size_t name_count)
+{
+	if (name_count > IRCMSG_TAG_FILTER_MAX) return false;
+	// Every name is checked before the filter is touched, so that a
+	// failure leaves it as it was.
+	for (size_t i = 0; i < name_count; ++i) {
+		if (names[i][0] == '\0') return false;
 	}
 
-	// Empty tag values and no tag values are equivalent.
-	if (value_len == 0) {
-		value_head = NULL;
+	memset(filter->first_bytes, 0, sizeof(filter->first_bytes));
+	filter->count = 0;
+	for (size_t i = 0; i < name_count; ++i) {
+		size_t name_len = strlen(names[i]);
+		uint8_t first = (uint8_t) names[i][0];
+		filter->first_bytes[first >> 6] |= UINT64_C(1) << (first & 63);
+		filter->names[i] = names[i];
+		filter->name_lens[i] = name_len;
+		++filter->count;
 	}
 
-	cbs->on_tag(name_head, name_len, value_head, value_len, user_data);
-}
-
-typedef enum {
-	// These states are "uninterruptable" as in if we encounter CRLF
-	// in any of these states, the parsing fails.
-	SEARCHING_TAGS_PREFIX_COMMAND,
-	PARSING_TAGS,
-	SEARCHING_PREFIX_COMMAND,
-	PARSING_PREFIX,
-	SEARCHING_COMMAND,
-	// These states are "interruptable" as in if we encounter CRLF,
-	// parsing succeeds.
-	PARSING_COMMAND,
-	SEARCHING_PARAMS,
-	PARSING_PARAMS,
-	PARSING_TRAILING_PARAM,
-} parsing_state;
+	return true;
+}
 
 size_t
 ircmsg_parse(const uint8_t *buf,
@@ -92,268 +305,582 @@ ircmsg_parse(const uint8_t *buf,
 	     const ircmsg_parser_callbacks *cbs,
 	     void *user_data)
 {
-	size_t bytes_consumed = 0;
-
-	bool hit_error = false;
-	bool message_started = false;
-	bool params_started = false;
-	parsing_state current_state = SEARCHING_TAGS_PREFIX_COMMAND;
-
-	const uint8_t *head = buf;
-	for (const uint8_t *iter = buf; iter < buf + buf_size; ++iter, ++bytes_consumed) {
-		// If we're not on the last parameter of a command,
-		// which may contain whitespaces, jump to the next
-		// character to seek for the next message token.
-		if ((current_state != PARSING_TRAILING_PARAM) && is_irc_whitespace (*iter)) {
-			// Special consideration is needed if we're currently
-			// parsing something.
-			if (current_state == PARSING_TAGS) {
-				if (head != iter) {
-					parse_tag(head, iter, cbs, user_data);
-					head = iter + 1;
-					current_state = SEARCHING_PREFIX_COMMAND;
-				}
-			} else if (current_state == PARSING_PREFIX) {
-				cbs->on_prefix(head, iter - head, user_data);
-				head = iter + 1;
-				current_state = SEARCHING_COMMAND;
-			} else if (current_state == PARSING_COMMAND) {
-				cbs->on_command(head, iter - head, user_data);
-				head = iter + 1;
-				current_state = SEARCHING_PARAMS;
-			} else if (current_state == PARSING_PARAMS) {
-				cbs->on_param(head, iter-head, user_data);
-				head = iter + 1;
-				current_state = SEARCHING_PARAMS;
-			} else {
-				head = iter + 1;
-			}
-		}
+	return ircmsg_parse_ex(buf, buf_size, cbs, user_data, NULL);
+}
 
-		// The IRC spec specifies that messages are terminated by
-		// bytes 0x13 followed by 0x10 (CRLF or \r\n). However, the
-		// other party might not be fully spec compliant and might
-		// send either only one of them or first LF and then CR.
-		//
-		// We must be able to cope with all of these situations. In
-		// particular, we want to consume both bytes, if they exist.
-		if (*iter == '\r' || *iter == '\n') {
-			bool was_cr = *iter == '\r';
-			bool was_lf = *iter == '\n';
-			if (current_state == PARSING_TAGS) {
-				cbs->on_error(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE, user_data);
-				hit_error = true;
-				break;
-			}
-			if (iter != (buf + buf_size) - 1) {
-				if (was_lf && *(iter + 1) == '\r') {
-					bytes_consumed += 2;
-					iter += 2;
-				        if (current_state >= PARSING_COMMAND) {
-						switch (current_state) {
-						case PARSING_COMMAND:
-							cbs->on_command(head, iter - head - 2, user_data);
-							break;
-						case PARSING_PARAMS:
-						case PARSING_TRAILING_PARAM:
-							cbs->on_param(head, iter - head - 2, user_data);
-							cbs->end_params(user_data);
-							break;
-						case SEARCHING_PARAMS:
-							break;
-						default:
-							// Shouldn't happen!
-							break;
-						}
-						cbs->end_message(user_data);
-					} else if (current_state > SEARCHING_TAGS_PREFIX_COMMAND) {
-						cbs->on_error(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE, user_data);
-						hit_error = true;
-						break;
-					} else {
-						cbs->on_error(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND, user_data);
-						hit_error = true;
-					}
-					break;
-				} else if (was_cr && *(iter + 1) == '\n') {
-					bytes_consumed += 2;
-					iter += 2;
-				        if (current_state >= PARSING_COMMAND) {
-						switch (current_state) {
-						case PARSING_COMMAND:
-							cbs->on_command(head, iter - head - 2, user_data);
-							break;
-						case PARSING_PARAMS:
-						case PARSING_TRAILING_PARAM:
-							cbs->on_param(head, iter - head - 2, user_data);
-							cbs->end_params(user_data);
-							break;
-						case SEARCHING_PARAMS:
-							break;
-						default:
-							// Shouldn't happen!
-							break;
-						}
-						cbs->end_message(user_data);
-					} else if (current_state > SEARCHING_TAGS_PREFIX_COMMAND) {
-						cbs->on_error(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE, user_data);
-						hit_error = true;
-						break;
-					} else {
-						cbs->on_error(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND, user_data);
-						hit_error = true;
-					}
-					break;
-				} else if (was_lf && *(iter + 1) == '\n') {
-					cbs->on_error(IRCMSG_ERR_PARSER_INVALID_SENTINEL, user_data);
-					hit_error = true;
-					break;
-				} else if (was_cr && *(iter + 1) == '\r') {
-					cbs->on_error(IRCMSG_ERR_PARSER_INVALID_SENTINEL, user_data);
-					hit_error = true;
-					break;
-				} else {
-					if (current_state >= PARSING_COMMAND) {
-						switch (current_state) {
-						case PARSING_COMMAND:
-							cbs->on_command(head, iter - head - 1, user_data);
-							break;
-						case PARSING_PARAMS:
-						case PARSING_TRAILING_PARAM:
-							cbs->on_param(head, iter - head - 1, user_data);
-							cbs->end_params(user_data);
-							break;
-						case SEARCHING_PARAMS:
-							break;
-						default:
-							// Shouldn't happen!
-							break;
-						}
-						cbs->end_message(user_data);
-					} else if (current_state > SEARCHING_TAGS_PREFIX_COMMAND) {
-						cbs->on_error(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE, user_data);
-						hit_error = true;
-						break;
-					} else {
-						cbs->on_error(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND, user_data);
-						hit_error = true;
-					}
-					break;
-				}
-			} else {
-				if (current_state >= PARSING_COMMAND) {
-					switch (current_state) {
-					case PARSING_COMMAND:
-						cbs->on_command(head, iter - head - 1, user_data);
-						break;
-					case PARSING_PARAMS:
-						cbs->on_param(head, iter - head - 1, user_data);
-						cbs->end_params(user_data);
-						break;
-					case PARSING_TRAILING_PARAM:
-						cbs->on_param(head, iter - head - 1, user_data);
-						cbs->end_params(user_data);
-						break;
-					case SEARCHING_PARAMS:
-						break;
-					default:
-						// Shouldn't happen!
-						break;
-					}
-					cbs->end_message(user_data);
-					break;
-				} else {
-					cbs->on_error(IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND, user_data);
-					hit_error = true;
-				}
-			}
+size_t
+ircmsg_parse_ex(const uint8_t *buf,
+		size_t buf_size,
+		const ircmsg_parser_callbacks *cbs,
+		void *user_data,
+		const ircmsg_parser_limits *limits)
+{
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	size_t consumed = 0;
+	if (parse_message(&st, buf, buf_size, true, &consumed,
+			  cbs, user_data) != IRCMSG_PARSE_DONE) {
+		return 0;
+	}
+	return consumed;
+}
+
+size_t
+ircmsg_parse_to_view(const uint8_t *buf,
+		     size_t buf_size,
+		     ircmsg_message_view *view)
+{
+	return ircmsg_parse_to_view_ex(buf, buf_size, view, NULL);
+}
+
+size_t
+ircmsg_parse_to_view_ex(const uint8_t *buf,
+			size_t buf_size,
+			ircmsg_message_view *view,
+			const ircmsg_parser_limits *limits)
+{
+	view->tag_count = 0;
+	view->tag_section.offset = 0;
+	view->tag_section.len = 0;
+	view->has_prefix = false;
+	view->prefix.offset = 0;
+	view->prefix.len = 0;
+	memset(&view->prefix_parts, 0, sizeof(view->prefix_parts));
+	view->command.offset = 0;
+	view->command.len = 0;
+	view->command_id = IRCMSG_CMD_UNKNOWN;
+	view->param_count = 0;
+
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	size_t consumed = 0;
+	if (parse_message_to_view(&st, buf, buf_size, true, &consumed,
+				  view) != IRCMSG_PARSE_DONE) {
+		return 0;
+	}
+
+	// The counts were kept going past the end of the arrays, so that
+	// the caller knows how big they need to be.
+	if (view->tag_count > view->tags_cap ||
+	    view->param_count > view->params_cap) {
+		view->error = IRCMSG_ERR_PARSER_VIEW_OVERFLOW;
+		return 0;
+	}
+
+	return consumed;
+}
+
+size_t
+ircmsg_parse_batch(const uint8_t *buf,
+		   size_t buf_size,
+		   const ircmsg_parser_callbacks *cbs,
+		   void *user_data)
+{
+	return ircmsg_parse_batch_ex(buf, buf_size, cbs, user_data, NULL);
+}
+
+size_t
+ircmsg_parse_batch_ex(const uint8_t *buf,
+		      size_t buf_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      void *user_data,
+		      const ircmsg_parser_limits *limits)
+{
+	// Everything before the last terminator in the buffer is made up
+	// of whole messages, so we can hand those to the parser as-is
+	// without looking for where each of them ends first.
+	const uint8_t *complete_end = ircmsg_find_complete_end(buf, buf + buf_size);
+
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	const uint8_t *iter = buf;
+	while (iter < complete_end) {
+		size_t consumed = 0;
+		if (parse_message(&st, iter, complete_end - iter, true,
+				  &consumed, cbs, user_data) != IRCMSG_PARSE_DONE) {
+			break;
 		}
+		iter += consumed;
+	}
+
+	return iter - buf;
+}
+
+size_t
+ircmsg_parse_batch_recover(const uint8_t *buf,
+			   size_t buf_size,
+			   const ircmsg_parser_callbacks *cbs,
+			   void *user_data,
+			   ircmsg_parser_error_counts *errors)
+{
+	return ircmsg_parse_batch_recover_ex(buf, buf_size, cbs, user_data,
+					     errors, NULL);
+}
+
+size_t
+ircmsg_parse_batch_recover_ex(const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_callbacks *cbs,
+			      void *user_data,
+			      ircmsg_parser_error_counts *errors,
+			      const ircmsg_parser_limits *limits)
+{
+	const uint8_t *complete_end = ircmsg_find_complete_end(buf, buf + buf_size);
 
-		// IRCv3 introduced so-called "tags" to messages. These tags are optional,
-		// but if they are present, the byte to indicate as much is 0x40 '@'.
-		if (*iter == 0x40 && current_state == SEARCHING_TAGS_PREFIX_COMMAND) {
-			current_state = PARSING_TAGS;
-			cbs->start_message(user_data);
-			message_started = true;
-			cbs->start_tags(user_data);
-			head = iter + 1;
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
 
+	const uint8_t *iter = buf;
+	while (iter < complete_end) {
+		// Empty lines are only worth an error when they are few and
+		// far between, which isn't the case here.
+		if (*iter == '\r' || *iter == '\n') {
+			++iter;
 			continue;
 		}
 
-		if (current_state == PARSING_TAGS) {
-			if (*iter == ';') {
-				parse_tag(head, iter, cbs, user_data);
-				head = iter + 1;
-			}
+		size_t consumed = 0;
+		ircmsg_parser_err_code error = IRCMSG_ERR_PARSER_END;
+		if (parse_message_noting_error(&st, iter, complete_end - iter, true,
+					       &consumed, cbs, user_data,
+					       &error) == IRCMSG_PARSE_DONE) {
+			iter += consumed;
 			continue;
 		}
 
-		// Now comes the prefix.
-		if (*iter == ':' &&
-		    (current_state == SEARCHING_TAGS_PREFIX_COMMAND ||
-		     current_state == SEARCHING_PREFIX_COMMAND)) {
-			current_state = PARSING_PREFIX;
-			if (!message_started) {
-				cbs->start_message(user_data);
-				message_started = true;
-			}
-			head = iter + 1;
-			continue;
+		if (errors != NULL && error < IRCMSG_ERR_PARSER_END) {
+			++errors->counts[error];
 		}
 
-		// Now comes the command.
-		if (!is_irc_whitespace(*iter) &&
-		    ((current_state == SEARCHING_TAGS_PREFIX_COMMAND) ||
-		     (current_state == SEARCHING_PREFIX_COMMAND) ||
-		     (current_state == SEARCHING_COMMAND))) {
-			if (!message_started) {
-				cbs->start_message(user_data);
-				message_started = true;
-			}
-			current_state = PARSING_COMMAND;
-			head = iter;
-			continue;
+		// Most errors are found at the terminator that ends the
+		// message, but e.g. a message that is too long is given up
+		// on before it, so the terminator is looked for from the
+		// start of the message. The next one starts right after it.
+		iter = ircmsg_find_line_end(iter, complete_end);
+	}
+
+	return iter - buf;
+}
+
+size_t
+ircmsg_parse_batch_controlled(const uint8_t *buf,
+			      size_t buf_size,
+			      const ircmsg_parser_control_callbacks *cbs,
+			      void *user_data)
+{
+	return ircmsg_parse_batch_controlled_ex(buf, buf_size, cbs, user_data,
+						NULL);
+}
+
+size_t
+ircmsg_parse_batch_controlled_ex(const uint8_t *buf,
+				 size_t buf_size,
+				 const ircmsg_parser_control_callbacks *cbs,
+				 void *user_data,
+				 const ircmsg_parser_limits *limits)
+{
+	const uint8_t *complete_end = ircmsg_find_complete_end(buf, buf + buf_size);
+
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	ircmsg_parser_control control = IRCMSG_PARSER_CONTINUE;
+	const uint8_t *iter = buf;
+	while (iter < complete_end) {
+		size_t consumed = 0;
+		if (parse_message_controlled(&st, iter, complete_end - iter, true,
+					     &consumed, cbs, user_data,
+					     &control) != IRCMSG_PARSE_DONE) {
+			break;
 		}
+		iter += consumed;
 
-		// Now we're at the params.
-		if (current_state == SEARCHING_PARAMS) {
-			// If we encounter a colon, that means that we have the
-			// trailing argument.
-			if (*iter == ':') {
-				if (!params_started) {
-					cbs->start_params(user_data);
-					params_started = true;
-				}
-
-				head = iter + 1;
-				current_state = PARSING_TRAILING_PARAM;
-				continue;
-			}
+		// Whatever the last callbacks of a message asked for, only
+		// an abort still matters once it has ended.
+		if (control_take(&control) == IRCMSG_PARSER_ABORT) break;
+	}
+
+	return iter - buf;
+}
+
+size_t
+ircmsg_find_frames(const uint8_t *buf,
+		   size_t buf_size,
+		   size_t *frame_ends,
+		   size_t frame_cap,
+		   bool *invalid)
+{
+	*invalid = false;
+
+	size_t frame_count = 0;
+	const uint8_t *const end = buf + buf_size;
+	const uint8_t *iter = buf;
+	while (frame_count < frame_cap) {
+		iter = ircmsg_find_line_end(iter, end);
+		if (iter == end) break;
+
+		// The same rules as when the parser finds the end of a
+		// message.
+		if (iter == end - 1) {
+			if (*iter == '\r') break;
+			iter += 1;
+		} else if (*iter == *(iter + 1)) {
+			*invalid = true;
+			break;
+		} else if (*(iter + 1) == '\r' || *(iter + 1) == '\n') {
+			iter += 2;
+		} else {
+			iter += 1;
+		}
+
+		frame_ends[frame_count++] = iter - buf;
+	}
+
+	return frame_count;
+}
+
+size_t
+ircmsg_parse_stream(ircmsg_parser_state *state,
+		    const uint8_t *buf,
+		    size_t buf_size,
+		    const ircmsg_parser_callbacks *cbs,
+		    void *user_data)
+{
+	const uint8_t *iter = buf;
+	const uint8_t *const end = buf + buf_size;
+
+	// The previous message ended in an LF that was the last byte we
+	// had, so a CR here completes its LFCR instead of being the
+	// start of a new message, and another LF makes an LFLF, which
+	// stops the parse as it would in one buffer.
+	if (state->skip_cr && iter < end) {
+		if (*iter == '\n') {
+			IRCMSG_STATS_ERROR(IRCMSG_ERR_PARSER_INVALID_SENTINEL);
+			cbs->on_error(IRCMSG_ERR_PARSER_INVALID_SENTINEL, user_data);
+			return 0;
+		}
+		state->skip_cr = false;
+		if (*iter == '\r') ++iter;
+	}
 
-			// Otherwise, if we encounter a non-whitespace,
-			// make it a param.
-			if (!is_irc_whitespace(*iter)) {
-				head = iter;
-				current_state = PARSING_PARAMS;
+	while (iter < end) {
+		size_t consumed = 0;
+		ircmsg_parse_result result = parse_message(state, iter, end - iter,
+						    false, &consumed,
+						    cbs, user_data);
+		if (result != IRCMSG_PARSE_DONE) break;
+
+		iter += consumed;
+		if (iter == end && *(iter - 1) == '\n' &&
+		    (consumed < 2 || *(iter - 2) != '\r')) {
+			state->skip_cr = true;
+		}
+	}
+
+	return iter - buf;
+}
+
+// Parses the complete messages in [iter, end) one after the other,
+// like a batch, returning where it stopped. The parser may look at
+// the bytes up to `buf_end` to tell how the last message ends.
+static const uint8_t *
+parse_complete(const uint8_t *iter, const uint8_t *end, const uint8_t *buf_end,
+	       const ircmsg_parser_callbacks *cbs, void *user_data,
+	       const ircmsg_parser_limits *limits)
+{
+	ircmsg_parser_state st;
+	ircmsg_engine_init_limits(&st, limits);
+
+	while (iter < end) {
+		size_t consumed = 0;
+		if (parse_message(&st, iter, buf_end - iter, true,
+				  &consumed, cbs, user_data) != IRCMSG_PARSE_DONE) {
+			break;
+		}
+		iter += consumed;
+	}
 
-				if (!params_started) {
-					cbs->start_params(user_data);
-					params_started = true;
-				}
+	return iter;
+}
 
-				continue;
+static inline bool
+is_token_state(int parsing_state)
+{
+	switch (parsing_state) {
+	case IRCMSG_PARSING_TAGS:
+	case IRCMSG_PARSING_PREFIX:
+	case IRCMSG_PARSING_COMMAND:
+	case IRCMSG_PARSING_PARAMS:
+	case IRCMSG_PARSING_TRAILING_PARAM:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// Whether the last byte of [buf, end) is a CR or LF that starts a
+// message of its own when parsing from `buf`, which then fails in a
+// way that depends on the byte after it. A message takes the first
+// CR or LF after it, and the next one too if it's the other of the
+// two, so that's the third byte of a run like CRLFCR, or a buffer
+// that is nothing but said CR or LF.
+static bool
+ends_in_empty_message(const uint8_t *buf, const uint8_t *end)
+{
+	size_t run = 0;
+	while (buf + run < end &&
+	       (*(end - 1 - run) == '\r' || *(end - 1 - run) == '\n')) {
+		++run;
+	}
+	if (buf + run == end) return run == 1;
+	return run == 3 && *(end - 3) != *(end - 2);
+}
+
+size_t
+ircmsg_parse_segments(const uint8_t *first,
+		      size_t first_size,
+		      const uint8_t *second,
+		      size_t second_size,
+		      const ircmsg_parser_callbacks *cbs,
+		      ircmsg_split_token_cb on_split_token,
+		      void *user_data)
+{
+	return ircmsg_parse_segments_ex(first, first_size, second, second_size,
+					cbs, on_split_token, user_data, NULL);
+}
+
+size_t
+ircmsg_parse_segments_ex(const uint8_t *first,
+			 size_t first_size,
+			 const uint8_t *second,
+			 size_t second_size,
+			 const ircmsg_parser_callbacks *cbs,
+			 ircmsg_split_token_cb on_split_token,
+			 void *user_data,
+			 const ircmsg_parser_limits *limits)
+{
+	const uint8_t *const first_end = first + first_size;
+	const uint8_t *const second_end = second + second_size;
+	const uint8_t *complete_end = ircmsg_find_complete_end(second, second_end);
+	if (second_size == 1 && *second == '\r' &&
+	    first_size > 0 && *(first_end - 1) == '\n') {
+		// The CR of an LFCR.
+		complete_end = second_end;
+	}
+
+	if (second_size > 0 && ends_in_empty_message(first, first_end)) {
+		// Only the byte after the seam tells whether that's a CRCR
+		// or LFLF, or just no message at all, as it would in one
+		// buffer, provided that byte is part of a complete message.
+		const uint8_t *const last = first_end - 1;
+		const uint8_t *const stop = parse_complete(first, last,
+							   first_end, cbs,
+							   user_data, limits);
+		if (stop == last) {
+			ircmsg_parser_err_code error =
+				complete_end > second && *second == *last ?
+				IRCMSG_ERR_PARSER_INVALID_SENTINEL :
+				IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND;
+			IRCMSG_STATS_ERROR(error);
+			cbs->on_error(error, user_data);
+		}
+		return stop - first;
+	}
+
+	// An LF at the end of the first segment followed by another one
+	// at the start of the second is an error in the message that the
+	// first LF ends, so that LF is held back, like a CR that may be
+	// the start of a CRLF.
+	const bool hold_lf = first_size > 0 && *(first_end - 1) == '\n' &&
+			     second_size > 0 && *second == '\n';
+	const uint8_t *const tail_end = hold_lf ? first_end - 1 : first_end;
+	const bool ends_in_cr = tail_end > first && *(tail_end - 1) == '\r';
+
+	// Everything in the first segment, up to the message that
+	// continues in the second one, if any. The parser may look one
+	// byte past the last of these messages, as long as that byte is
+	// part of a complete message too.
+	const uint8_t *iter = ircmsg_find_complete_end(first, tail_end);
+	const uint8_t *stop = parse_complete(first, iter,
+					     complete_end > second ||
+					     (ends_in_cr && second_size > 0) ?
+					     first_end : iter,
+					     cbs, user_data, limits);
+	if (stop != iter) return stop - first;
+
+	const uint8_t *second_iter = second;
+	if (iter == first_end && iter > first && *(iter - 1) == '\n' &&
+	    (iter - first < 2 || *(iter - 2) != '\r') &&
+	    second_size > 0 && *second == '\r') {
+		++second_iter;
+	}
+
+	if (iter < first_end) {
+		// The rest of the first segment has no terminator but maybe
+		// a CR as its last byte, so the message only ends in the
+		// second segment, if at all.
+		size_t tail_len = tail_end - iter;
+		if (ends_in_cr ? second_size == 0 : complete_end == second) {
+			return iter - first;
+		}
+
+		ircmsg_parser_state st;
+		ircmsg_engine_init_limits(&st, limits);
+
+		size_t consumed = 0;
+		bool lone_cr = !hold_lf && ends_in_cr && *second != '\n' &&
+			       (*second != '\r' || complete_end == second);
+		if (parse_message(&st, iter, tail_len, lone_cr, &consumed,
+				  cbs, user_data) == IRCMSG_PARSE_ERROR) {
+			return iter - first;
+		}
+
+		if (lone_cr) {
+			return first_size +
+				(parse_complete(second, complete_end, complete_end,
+						cbs, user_data, limits) - second);
+		} else if (ends_in_cr && (hold_lf || *second == '\n')) {
+			// Finishing a CRLF, which may be split by the seam.
+			if (parse_message(&st, iter, tail_len + hold_lf, true,
+					  &consumed, cbs, user_data) != IRCMSG_PARSE_DONE) {
+				return iter - first;
+			}
+			if (!hold_lf) ++second_iter;
+		} else if (ends_in_cr || hold_lf) {
+			cbs->on_error(st.parsing_state == IRCMSG_PARSING_TAGS ?
+				      IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE :
+				      IRCMSG_ERR_PARSER_INVALID_SENTINEL,
+				      user_data);
+			return iter - first;
+		} else {
+			// Carry on right where the first segment ended.
+			struct seam seam = {
+				.second = second,
+				.first_part = iter + st.head,
+				.first_part_len = tail_len - st.head,
+				.pending = is_token_state(st.parsing_state) &&
+					   st.head < tail_len,
+				.on_split_token = on_split_token,
+			};
+			// The offsets now count from the second segment, and
+			// so the limits start over from there too.
+			st.head = 0;
+			st.scanned = 0;
+			st.body_start = 0;
+
+			// A tag that ends right at the seam is not split,
+			// and has to be let go of here, as the parser only
+			// ends the tags on a space after a non-empty tag.
+			if (seam.pending && st.parsing_state == IRCMSG_PARSING_TAGS &&
+			    ircmsg_is_irc_whitespace(*second)) {
+				seam_on_tag(&seam, cbs, second, second, user_data);
+				st.parsing_state = IRCMSG_SEARCHING_PREFIX_COMMAND;
+				st.tags_open = false;
+				st.head = 1;
+				st.scanned = 1;
 			}
+
+			if (parse_message_seam(&st, second, complete_end - second,
+					       true, &consumed, cbs, user_data,
+					       &seam) != IRCMSG_PARSE_DONE) {
+				return iter - first;
+			}
+			second_iter += consumed;
 		}
 	}
 
-	if ((current_state == SEARCHING_TAGS_PREFIX_COMMAND && !hit_error) ||
-	    (current_state < SEARCHING_COMMAND && !hit_error)) {
-		cbs->on_error(IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE, user_data);
-		hit_error = true;
+	return first_size +
+		(parse_complete(second_iter, complete_end, complete_end,
+				cbs, user_data, limits) - second);
+}
+
+void
+ircmsg_prefix_split(const uint8_t *prefix,
+		    size_t prefix_len,
+		    ircmsg_prefix_parts *parts)
+{
+	memset(parts, 0, sizeof(*parts));
+
+	// The nick ends at the first '!' or '@', and the user at the
+	// first '@' after that. Only server names have dots in them
+	// without either.
+	size_t name_end = prefix_len;
+	size_t user_start = 0;
+	size_t host_start = 0;
+	bool has_dot = false;
+	for (size_t i = 0; i < prefix_len; ++i) {
+		uint8_t byte = prefix[i];
+		if (byte == '!' && name_end == prefix_len) {
+			name_end = i;
+			user_start = i + 1;
+		} else if (byte == '@' && host_start == 0) {
+			if (name_end == prefix_len) name_end = i;
+			host_start = i + 1;
+			break;
+		} else if (byte == '.') {
+			has_dot = true;
+		}
+	}
+
+	parts->name.len = name_end;
+	if (user_start != 0) {
+		size_t user_end = host_start != 0 ? host_start - 1 : prefix_len;
+		parts->user.offset = user_start;
+		parts->user.len = user_end - user_start;
+	}
+	if (host_start != 0) {
+		parts->host.offset = host_start;
+		parts->host.len = prefix_len - host_start;
+	}
+	if (parts->user.len == 0) parts->user.offset = 0;
+	if (parts->host.len == 0) parts->host.offset = 0;
+
+	parts->is_server = user_start == 0 && host_start == 0 && has_dot;
+}
+
+bool
+ircmsg_tags_find(const uint8_t *tags,
+		 size_t tags_len,
+		 const char *name,
+		 const uint8_t **value,
+		 size_t *value_len)
+{
+	size_t wanted_len = strlen(name);
+
+	const uint8_t *head = tags;
+	const uint8_t *const end = tags + tags_len;
+	while (head < end) {
+		const uint8_t *tail = memchr(head, ';', end - head);
+		if (tail == NULL) tail = end;
+
+		// Only split the tags that may be the one wanted, which
+		// is checked for without having to look at the value.
+		size_t tag_len = tail - head;
+		if (tag_len >= wanted_len &&
+		    memcmp(head, name, wanted_len) == 0 &&
+		    (tag_len == wanted_len || head[wanted_len] == '=')) {
+			size_t name_len;
+			const uint8_t *tag_value;
+			size_t tag_value_len;
+			ircmsg_split_tag(head, tail, &name_len,
+					 &tag_value, &tag_value_len);
+			if (name_len == wanted_len) {
+				*value = tag_value;
+				*value_len = tag_value_len;
+				return true;
+			}
+		}
+
+		// Stepping over the end of the last tag, which has no
+		// `;` after it, would point past the end of the tags.
+		if (tail == end) break;
+		head = tail + 1;
 	}
 
-	return hit_error ? 0 : bytes_consumed;
+	return false;
 }
 
 static uint8_t
@@ -383,18 +910,15 @@ ircmsg_tag_value_unescaped_size(const uint8_t *esc_value,
 {
 	if (esc_value == NULL || esc_value_len == 0) return 0;
 
-	size_t bytes_needed = 0;
-	for (const uint8_t *iter = esc_value; iter < esc_value + esc_value_len; ++iter) {
-		if (*iter == '\\') {
-			if (iter == (esc_value + esc_value_len - 1)) {
-				break;
-			} else {
-				++iter;
-			        ++bytes_needed;
-			}
-		} else {
-			++bytes_needed;
-		}
+	// Every escape is two bytes that become one, except for a
+	// backslash at the very end, which is dropped.
+	size_t bytes_needed = esc_value_len;
+	const uint8_t *const end = esc_value + esc_value_len;
+	for (const uint8_t *iter = ircmsg_find_escape(esc_value, end);
+	     iter < end;
+	     iter = ircmsg_find_escape(iter + 2, end)) {
+		--bytes_needed;
+		if (iter == end - 1) break;
 	}
 
 	return bytes_needed;
@@ -407,20 +931,64 @@ ircmsg_tag_value_unescape(const uint8_t *esc_value,
 			  size_t buf_len)
 {
 	if (esc_value == NULL || esc_value_len == 0) return NULL;
-	size_t buf_index = 0;
-
-	for (const uint8_t *iter = esc_value; iter < esc_value + esc_value_len; ++iter) {
-		if (*iter == '\\') {
-			if (iter == (esc_value + esc_value_len - 1)) {
-				break;
-			} else {
-				++iter;
-			        buf[buf_index++] = byte_unescapes_to(*iter);
-			}
-		} else {
-		        buf[buf_index++] = *iter;
+
+	ircmsg_tag_value_unescape_into(esc_value, esc_value_len, buf, buf_len);
+        return buf;
+}
+
+size_t
+ircmsg_tag_value_unescape_into(const uint8_t *esc_value,
+			       size_t esc_value_len,
+			       uint8_t *buf,
+			       size_t buf_len)
+{
+	if (esc_value == NULL || esc_value_len == 0) return 0;
+
+	size_t written = 0;
+	const uint8_t *iter = esc_value;
+	const uint8_t *const end = esc_value + esc_value_len;
+	while (iter < end) {
+		// Copy everything up to the next escape at once.
+		const uint8_t *escape = ircmsg_find_escape(iter, end);
+		size_t run = escape - iter;
+		if (written < buf_len) {
+			memcpy(buf + written, iter,
+			       run < buf_len - written ? run : buf_len - written);
+		}
+		written += run;
+
+		if (escape >= end - 1) break;
+
+		if (written < buf_len) {
+			buf[written] = byte_unescapes_to(escape[1]);
 		}
+		++written;
+		iter = escape + 2;
 	}
 
-        return buf;
+	return written;
+}
+
+size_t
+ircmsg_tag_value_unescape_in_place(uint8_t *value, size_t value_len)
+{
+	if (value == NULL || value_len == 0) return 0;
+
+	// Nothing needs to move until the first escape.
+	const uint8_t *const end = value + value_len;
+	uint8_t *out = (uint8_t *) ircmsg_find_escape(value, end);
+	const uint8_t *iter = out;
+	while (iter < end) {
+		const uint8_t *escape = ircmsg_find_escape(iter, end);
+		size_t run = escape - iter;
+		memmove(out, iter, run);
+		out += run;
+
+		if (escape >= end - 1) break;
+
+		*out++ = byte_unescapes_to(escape[1]);
+		iter = escape + 2;
+	}
+
+	return out - value;
 }
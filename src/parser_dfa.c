@@ -0,0 +1,114 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/parser_engine.h"
+
+const uint8_t ircmsg_byte_classes[256] = {
+	[' '] = IRCMSG_CLASS_SPACE,
+	['\r'] = IRCMSG_CLASS_CR,
+	['\n'] = IRCMSG_CLASS_LF,
+	['@'] = IRCMSG_CLASS_AT,
+	[':'] = IRCMSG_CLASS_COLON,
+	[';'] = IRCMSG_CLASS_SEMICOLON,
+};
+
+// Shorthands for the rows of the table.
+#define IRCMSG_DFA_STAY(state)							\
+	IRCMSG_DFA(IRCMSG_DFA_NONE, (state))
+#define IRCMSG_DFA_SEARCH(state)						\
+	[IRCMSG_CLASS_SPACE] = IRCMSG_DFA(IRCMSG_DFA_SKIP_SPACE, (state)),	\
+	[IRCMSG_CLASS_CR] = IRCMSG_DFA(IRCMSG_DFA_TERMINATE, (state)),		\
+	[IRCMSG_CLASS_LF] = IRCMSG_DFA(IRCMSG_DFA_TERMINATE, (state))
+#define IRCMSG_DFA_COMMAND_ON(class)						\
+	[class] = IRCMSG_DFA(IRCMSG_DFA_START_COMMAND, IRCMSG_PARSING_COMMAND)
+#define IRCMSG_DFA_PARAM_ON(class)						\
+	[class] = IRCMSG_DFA(IRCMSG_DFA_START_PARAM, IRCMSG_PARSING_PARAMS)
+#define IRCMSG_DFA_TOKEN(state, action, next)					\
+	[IRCMSG_CLASS_OTHER] = IRCMSG_DFA_STAY(state),				\
+	[IRCMSG_CLASS_SPACE] = IRCMSG_DFA((action), (next)),			\
+	[IRCMSG_CLASS_CR] = IRCMSG_DFA(IRCMSG_DFA_TERMINATE, (state)),		\
+	[IRCMSG_CLASS_LF] = IRCMSG_DFA(IRCMSG_DFA_TERMINATE, (state)),		\
+	[IRCMSG_CLASS_AT] = IRCMSG_DFA_STAY(state),				\
+	[IRCMSG_CLASS_COLON] = IRCMSG_DFA_STAY(state),				\
+	[IRCMSG_CLASS_SEMICOLON] = IRCMSG_DFA_STAY(state)
+
+// The transitions of the state machine, for each state and each class
+// of byte. Inside a token, the only bytes ever looked at are the ones
+// the scan for its end stops at.
+const uint8_t ircmsg_dfa_table[IRCMSG_SKIPPING_MESSAGE + 1][IRCMSG_CLASS_SEMICOLON + 1] = {
+	[IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND] = {
+		IRCMSG_DFA_SEARCH(IRCMSG_SEARCHING_TAGS_PREFIX_COMMAND),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_OTHER),
+		[IRCMSG_CLASS_AT] = IRCMSG_DFA(IRCMSG_DFA_START_TAGS, IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_COLON] = IRCMSG_DFA(IRCMSG_DFA_START_PREFIX, IRCMSG_PARSING_PREFIX),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_SEMICOLON),
+	},
+	[IRCMSG_PARSING_TAGS] = {
+		[IRCMSG_CLASS_OTHER] = IRCMSG_DFA_STAY(IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_SPACE] = IRCMSG_DFA(IRCMSG_DFA_END_TAGS, IRCMSG_SEARCHING_PREFIX_COMMAND),
+		[IRCMSG_CLASS_CR] = IRCMSG_DFA(IRCMSG_DFA_UNEXPECTED_END, IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_LF] = IRCMSG_DFA(IRCMSG_DFA_UNEXPECTED_END, IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_AT] = IRCMSG_DFA_STAY(IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_COLON] = IRCMSG_DFA_STAY(IRCMSG_PARSING_TAGS),
+		[IRCMSG_CLASS_SEMICOLON] = IRCMSG_DFA(IRCMSG_DFA_NEXT_TAG, IRCMSG_PARSING_TAGS),
+	},
+	[IRCMSG_SEARCHING_PREFIX_COMMAND] = {
+		IRCMSG_DFA_SEARCH(IRCMSG_SEARCHING_PREFIX_COMMAND),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_OTHER),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_AT),
+		[IRCMSG_CLASS_COLON] = IRCMSG_DFA(IRCMSG_DFA_START_PREFIX, IRCMSG_PARSING_PREFIX),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_SEMICOLON),
+	},
+	[IRCMSG_PARSING_PREFIX] = {
+		IRCMSG_DFA_TOKEN(IRCMSG_PARSING_PREFIX,
+				 IRCMSG_DFA_END_PREFIX, IRCMSG_SEARCHING_COMMAND),
+	},
+	[IRCMSG_SEARCHING_COMMAND] = {
+		IRCMSG_DFA_SEARCH(IRCMSG_SEARCHING_COMMAND),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_OTHER),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_AT),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_COLON),
+		IRCMSG_DFA_COMMAND_ON(IRCMSG_CLASS_SEMICOLON),
+	},
+	[IRCMSG_PARSING_COMMAND] = {
+		IRCMSG_DFA_TOKEN(IRCMSG_PARSING_COMMAND,
+				 IRCMSG_DFA_END_COMMAND, IRCMSG_SEARCHING_PARAMS),
+	},
+	[IRCMSG_SEARCHING_PARAMS] = {
+		IRCMSG_DFA_SEARCH(IRCMSG_SEARCHING_PARAMS),
+		IRCMSG_DFA_PARAM_ON(IRCMSG_CLASS_OTHER),
+		IRCMSG_DFA_PARAM_ON(IRCMSG_CLASS_AT),
+		[IRCMSG_CLASS_COLON] = IRCMSG_DFA(IRCMSG_DFA_START_TRAILING, IRCMSG_PARSING_TRAILING_PARAM),
+		IRCMSG_DFA_PARAM_ON(IRCMSG_CLASS_SEMICOLON),
+	},
+	[IRCMSG_PARSING_PARAMS] = {
+		IRCMSG_DFA_TOKEN(IRCMSG_PARSING_PARAMS,
+				 IRCMSG_DFA_END_PARAM, IRCMSG_SEARCHING_PARAMS),
+	},
+	[IRCMSG_PARSING_TRAILING_PARAM] = {
+		IRCMSG_DFA_TOKEN(IRCMSG_PARSING_TRAILING_PARAM,
+				 IRCMSG_DFA_NONE, IRCMSG_PARSING_TRAILING_PARAM),
+	},
+	[IRCMSG_SKIPPING_MESSAGE] = {
+		IRCMSG_DFA_TOKEN(IRCMSG_SKIPPING_MESSAGE,
+				 IRCMSG_DFA_NONE, IRCMSG_SKIPPING_MESSAGE),
+	},
+};
+
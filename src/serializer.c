@@ -19,6 +19,8 @@
 //  DEALINGS IN THE SOFTWARE.
 
 #include "ircmsg/serializer.h"
+#include "serializer_tags.h"
+#include "stats_counters.h"
 #include <string.h>
 
 static size_t
@@ -31,33 +33,39 @@ is_tag_escapable(uint8_t byte);
 static uint8_t
 get_tag_escape(uint8_t byte);
 
-void
-ircmsg_serialize(uint8_t *buf,
-		 size_t buf_size,
-		 const ircmsg_serializer_callbacks *cbs,
-		 void *user_data)
-{
-	uint8_t *iter = buf;
-	uint8_t *buf_end = buf + buf_size;
-#define set_byte(byte)				\
-	do {					\
-		if (iter < buf_end) {		\
-			*iter = (byte);		\
-			++iter;			\
-		} else {			\
-			return;			\
-		}				\
+// Append to the message being serialized into `buf`. Everything is
+// counted in `len`, but only written while it still fits, so that a
+// message too large for `buf` yields the size it needs all the same.
+// Once a piece doesn't fit, `len` is past `buf_size` and no later
+// piece is written either.
+#define put_byte(byte)					\
+	do {						\
+		if (len < buf_size) {			\
+			buf[len] = (byte);		\
+		}					\
+		++len;					\
+	} while (false)
+#define put_bytes(src, n)				\
+	do {						\
+		size_t put_len = (n);			\
+		if (len <= buf_size &&			\
+		    put_len <= buf_size - len) {	\
+			memcpy(buf + len, (src),	\
+			       put_len);		\
+		}					\
+		len += put_len;				\
 	} while (false)
 
-        size_t tag_count = cbs->tag_count(user_data);
-	size_t param_count = cbs->param_count(user_data);
-
-	uint8_t tag_prefix = '@';
-	bool had_tags = false;
+size_t
+ircmsg_serialize_tags(uint8_t *buf,
+		      size_t buf_size,
+		      size_t len,
+		      size_t tag_count,
+		      const ircmsg_serializer_callbacks *cbs,
+		      void *user_data)
+{
 	for (size_t tag_idx = 0; tag_idx < tag_count; ++tag_idx) {
-		had_tags = true;
-		set_byte(tag_prefix);
-		if (tag_prefix == '@') tag_prefix = ';';
+		put_byte(tag_idx == 0 ? '@' : ';');
 		size_t tag_len = 0;
 		size_t val_len = 0;
 		const uint8_t *tag = NULL;
@@ -66,29 +74,43 @@ ircmsg_serialize(uint8_t *buf,
 			    &tag_len, &tag,
 			    &val_len, &val,
 			    user_data);
-		if ((iter + tag_len) >= buf_end) return;
-	        memcpy(iter, tag, tag_len);
-		iter += tag_len;
+		put_bytes(tag, tag_len);
 		if (val_len > 0) {
-			set_byte('=');
-		        size_t esc_len =
-				get_tag_value_escaped_size(val, val_len);
-			if ((iter + esc_len) >= buf_end) return;
+			put_byte('=');
+			// The value is escaped as it's copied, copying the
+			// runs between escapable bytes as they are.
+			const uint8_t *val_end = val + val_len;
+			const uint8_t *run = val;
 			for (const uint8_t *val_iter = val;
-			     val_iter < (val + val_len);
+			     val_iter < val_end;
 			     ++val_iter) {
-			        if (is_tag_escapable(*val_iter)) {
-					set_byte('\\');
-					set_byte(get_tag_escape(*val_iter));
-					continue;
-				}
-				set_byte(*val_iter);
+				if (!is_tag_escapable(*val_iter)) continue;
+				put_bytes(run, val_iter - run);
+				put_byte('\\');
+				put_byte(get_tag_escape(*val_iter));
+				run = val_iter + 1;
 			}
+			put_bytes(run, val_end - run);
 		}
 	}
-	if (had_tags) {
-		set_byte(' ');
+	if (tag_count > 0) {
+		put_byte(' ');
 	}
+	return len;
+}
+
+size_t
+ircmsg_serialize_checked(uint8_t *buf,
+			 size_t buf_size,
+			 const ircmsg_serializer_callbacks *cbs,
+			 void *user_data,
+			 bool *truncated)
+{
+	size_t tag_count = cbs->tag_count(user_data);
+	size_t param_count = cbs->param_count(user_data);
+
+	size_t len = ircmsg_serialize_tags(buf, buf_size, 0, tag_count,
+					   cbs, user_data);
 
 	{
 		size_t prefix_len = 0;
@@ -96,14 +118,9 @@ ircmsg_serialize(uint8_t *buf,
 		bool has_prefix = cbs->on_prefix(&prefix_len, &prefix,
 						 user_data);
 		if (has_prefix) {
-		        set_byte(':');
-
-			if ((iter + prefix_len) >= buf_end) return;
-			memcpy(iter, prefix, prefix_len);
-
-			iter += prefix_len;
-
-			set_byte(' ');
+			put_byte(':');
+			put_bytes(prefix, prefix_len);
+			put_byte(' ');
 		}
 	}
 
@@ -113,17 +130,14 @@ ircmsg_serialize(uint8_t *buf,
 
 		cbs->on_command(&command_len, &command, user_data);
 
-		if ((iter + command_len) >= buf_end) return;
-		memcpy(iter, command, command_len);
-
-		iter += command_len;
+		put_bytes(command, command_len);
 	}
 
 	for (size_t param_idx = 0; param_idx < param_count; ++param_idx) {
-		set_byte(' ');
+		put_byte(' ');
 		if (param_idx == (param_count - 1)) {
 			// The last argument is always treated as trailing.
-			set_byte(':');
+			put_byte(':');
 		}
 
 		size_t param_len = 0;
@@ -132,15 +146,32 @@ ircmsg_serialize(uint8_t *buf,
 		cbs->on_param(param_idx, &param_len, &param,
 			      user_data);
 
-		if ((iter + param_len) >= buf_end) return;
-		memcpy(iter, param, param_len);
+		put_bytes(param, param_len);
+	}
+
+	put_byte('\r');
+	put_byte('\n');
 
-		iter += param_len;
+	*truncated = len > buf_size;
+	if (!*truncated) {
+		IRCMSG_STATS_ADD(serialized_messages, 1);
+		IRCMSG_STATS_ADD(serialized_bytes, len);
 	}
+	return len;
+}
+
+#undef put_bytes
+#undef put_byte
 
-	set_byte('\r');
-	set_byte('\n');
-#undef set_byte
+void
+ircmsg_serialize(uint8_t *buf,
+		 size_t buf_size,
+		 const ircmsg_serializer_callbacks *cbs,
+		 void *user_data)
+{
+	bool truncated = false;
+	(void) ircmsg_serialize_checked(buf, buf_size, cbs, user_data,
+					&truncated);
 }
 
 size_t
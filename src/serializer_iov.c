@@ -0,0 +1,178 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/serializer_iov.h"
+#include "serializer_tags.h"
+#include "stats_counters.h"
+#include <string.h>
+
+// Pieces of the caller's message shorter than this are copied to the
+// scratch space when it has room for them, as an iovec of their own
+// would cost writev(2) more than the copy.
+#define IOV_COPY_LEN 32
+
+struct iov_writer
+{
+	struct iovec *iov;
+	size_t iov_cap;
+	size_t iov_count;
+	uint8_t *scratch;
+	size_t scratch_size;
+	size_t scratch_len;
+	// How much of the scratch space the separators still to come
+	// need, which short pieces may not take up.
+	size_t reserved;
+	size_t msg_len;
+	bool failed;
+};
+
+static void
+push(struct iov_writer *w, const uint8_t *base, size_t len)
+{
+	w->msg_len += len;
+	if (w->iov_count > 0) {
+		struct iovec *last = &w->iov[w->iov_count - 1];
+		if ((const uint8_t *) last->iov_base + last->iov_len == base) {
+			last->iov_len += len;
+			return;
+		}
+	}
+	if (w->iov_count == w->iov_cap) {
+		w->failed = true;
+		return;
+	}
+	w->iov[w->iov_count].iov_base = (void *) base;
+	w->iov[w->iov_count].iov_len = len;
+	++w->iov_count;
+}
+
+static void
+push_copy(struct iov_writer *w, const uint8_t *src, size_t len)
+{
+	uint8_t *dst = w->scratch + w->scratch_len;
+	memcpy(dst, src, len);
+	w->scratch_len += len;
+	push(w, dst, len);
+}
+
+static void
+push_separator(struct iov_writer *w, const char *sep, size_t len)
+{
+	if (w->scratch_size - w->scratch_len < len) {
+		w->failed = true;
+		return;
+	}
+	w->reserved -= len;
+	push_copy(w, (const uint8_t *) sep, len);
+}
+
+static void
+push_piece(struct iov_writer *w, const uint8_t *piece, size_t len)
+{
+	if (len == 0) return;
+	if (len < IOV_COPY_LEN &&
+	    w->scratch_size - w->scratch_len >= w->reserved + len) {
+		push_copy(w, piece, len);
+	} else {
+		push(w, piece, len);
+	}
+}
+
+size_t
+ircmsg_serialize_iov(struct iovec *iov,
+		     size_t iov_cap,
+		     uint8_t *scratch,
+		     size_t scratch_size,
+		     const ircmsg_serializer_callbacks *cbs,
+		     void *user_data,
+		     size_t *msg_len)
+{
+	struct iov_writer w = {
+		.iov = iov,
+		.iov_cap = iov_cap,
+		.scratch = scratch,
+		.scratch_size = scratch_size,
+	};
+	*msg_len = 0;
+
+	size_t tag_count = cbs->tag_count(user_data);
+	size_t param_count = cbs->param_count(user_data);
+
+	size_t tags_len = ircmsg_serialize_tags(scratch, scratch_size, 0,
+						tag_count, cbs, user_data);
+	if (tags_len > scratch_size) return 0;
+	w.scratch_len = tags_len;
+	if (tags_len > 0) {
+		push(&w, scratch, tags_len);
+	}
+
+	size_t prefix_len = 0;
+	const uint8_t *prefix = NULL;
+	bool has_prefix = cbs->on_prefix(&prefix_len, &prefix, user_data);
+
+	// The ':' and ' ' around the prefix, one ' ' per param, the ':'
+	// of the trailing one, and the CRLF.
+	w.reserved = (has_prefix ? 2 : 0) + param_count +
+		(param_count > 0 ? 1 : 0) + 2;
+	if (scratch_size - w.scratch_len < w.reserved) return 0;
+
+	if (has_prefix) {
+		push_separator(&w, ":", 1);
+		push_piece(&w, prefix, prefix_len);
+		push_separator(&w, " ", 1);
+	}
+
+	{
+		size_t command_len = 0;
+		const uint8_t *command = NULL;
+
+		cbs->on_command(&command_len, &command, user_data);
+
+		push_piece(&w, command, command_len);
+	}
+
+	for (size_t param_idx = 0;
+	     param_idx < param_count && !w.failed;
+	     ++param_idx) {
+		// The last argument is always treated as trailing.
+		if (param_idx == (param_count - 1)) {
+			push_separator(&w, " :", 2);
+		} else {
+			push_separator(&w, " ", 1);
+		}
+
+		size_t param_len = 0;
+		const uint8_t *param = NULL;
+
+		cbs->on_param(param_idx, &param_len, &param,
+			      user_data);
+
+		push_piece(&w, param, param_len);
+	}
+
+	push_separator(&w, "\r\n", 2);
+
+	if (w.failed) return 0;
+
+	IRCMSG_STATS_ADD(serialized_messages, 1);
+	IRCMSG_STATS_ADD(serialized_bytes, w.msg_len);
+	*msg_len = w.msg_len;
+	return w.iov_count;
+}
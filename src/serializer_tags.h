@@ -0,0 +1,42 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// What the serializers in serializer.c and serializer_iov.c share.
+
+#ifndef __SERIALIZER_TAGS_H_
+#define __SERIALIZER_TAGS_H_
+
+#include <ircmsg/serializer.h>
+
+// Serializes the first `tag_count` tags of the message described by
+// `cbs` into `buf`, starting at offset `len`, with the '@' before them
+// and the space after them, if there are any. Like
+// ircmsg_serialize_checked, only what fits in `buf_size` is written,
+// but everything is counted: the offset past the tags is returned
+// even if it's past `buf_size`.
+size_t
+ircmsg_serialize_tags(uint8_t *buf,
+		      size_t buf_size,
+		      size_t len,
+		      size_t tag_count,
+		      const ircmsg_serializer_callbacks *cbs,
+		      void *user_data);
+
+#endif /* __SERIALIZER_TAGS_H_ */
@@ -0,0 +1,168 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/simd.h"
+#include "ircmsg/parser_engine.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const level_names[] = {
+	[IRCMSG_SIMD_SCALAR] = "scalar",
+	[IRCMSG_SIMD_SSE2] = "sse2",
+	[IRCMSG_SIMD_AVX2] = "avx2",
+	[IRCMSG_SIMD_AVX512] = "avx512",
+};
+
+#define LEVEL_COUNT (sizeof(level_names) / sizeof(level_names[0]))
+
+const char *
+ircmsg_simd_level_name(ircmsg_simd_level level)
+{
+	return (size_t) level < LEVEL_COUNT ? level_names[level] : NULL;
+}
+
+#ifdef IRCMSG_SCAN_DISPATCH
+
+// Each level's kernels are the scans from ircmsg/parser_engine.h for
+// said level, with the bytes they look for baked in.
+#define SCAN_KERNELS(level, scan, target)				\
+	target static const uint8_t *					\
+	line_end_##level(const uint8_t *iter, const uint8_t *end)	\
+	{								\
+		return scan(iter, end, '\r', '\n', '\r', '\n');		\
+	}								\
+	target static const uint8_t *					\
+	token_end_##level(const uint8_t *iter, const uint8_t *end)	\
+	{								\
+		return scan(iter, end, ' ', '\r', '\n', ' ');		\
+	}								\
+	target static const uint8_t *					\
+	tag_end_##level(const uint8_t *iter, const uint8_t *end)	\
+	{								\
+		return scan(iter, end, ';', ' ', '\r', '\n');		\
+	}								\
+	target static const uint8_t *					\
+	escape_##level(const uint8_t *iter, const uint8_t *end)	\
+	{								\
+		return scan(iter, end, '\\', '\\', '\\', '\\');		\
+	}
+
+#define KERNELS(level)							\
+	{ line_end_##level, token_end_##level, tag_end_##level, escape_##level }
+
+SCAN_KERNELS(scalar, ircmsg_scan_swar, )
+#if defined(IRCMSG_SCAN_X86)
+SCAN_KERNELS(sse2, ircmsg_scan_sse2, IRCMSG_SCAN_TARGET("sse2"))
+SCAN_KERNELS(avx2, ircmsg_scan_avx2, IRCMSG_SCAN_TARGET("avx2"))
+SCAN_KERNELS(avx512, ircmsg_scan_avx512, IRCMSG_SCAN_TARGET("avx512bw"))
+#endif
+
+static const ircmsg_scan_kernels kernels[] = {
+	[IRCMSG_SIMD_SCALAR] = KERNELS(scalar),
+#if defined(IRCMSG_SCAN_X86)
+	[IRCMSG_SIMD_SSE2] = KERNELS(sse2),
+	[IRCMSG_SIMD_AVX2] = KERNELS(avx2),
+	[IRCMSG_SIMD_AVX512] = KERNELS(avx512),
+#endif
+};
+
+#define KERNEL_COUNT (sizeof(kernels) / sizeof(kernels[0]))
+
+// Until the level is picked, the kernels that run everywhere. This is
+// also what tells which level is in use.
+const ircmsg_scan_kernels *ircmsg_scan = &kernels[IRCMSG_SIMD_SCALAR];
+
+static bool
+cpu_supports(ircmsg_simd_level level)
+{
+	switch (level) {
+	case IRCMSG_SIMD_SCALAR:
+		return true;
+#if defined(IRCMSG_SCAN_X86)
+	case IRCMSG_SIMD_SSE2:
+		return __builtin_cpu_supports("sse2");
+	case IRCMSG_SIMD_AVX2:
+		return __builtin_cpu_supports("avx2");
+	case IRCMSG_SIMD_AVX512:
+		return __builtin_cpu_supports("avx512bw");
+#endif
+	default:
+		return false;
+	}
+}
+
+ircmsg_simd_level
+ircmsg_simd_get_level(void)
+{
+	return (ircmsg_simd_level) (__atomic_load_n(&ircmsg_scan, __ATOMIC_ACQUIRE) - kernels);
+}
+
+bool
+ircmsg_simd_set_level(ircmsg_simd_level level)
+{
+	if ((size_t) level >= KERNEL_COUNT || !cpu_supports(level)) {
+		return false;
+	}
+	__atomic_store_n(&ircmsg_scan, &kernels[level], __ATOMIC_RELEASE);
+	return true;
+}
+
+// Picks the highest level the CPU supports, or the one asked for in
+// IRCMSG_SIMD, once the library is loaded. A level the CPU cannot run
+// falls back to the best one below it.
+__attribute__((constructor)) static void
+pick_level(void)
+{
+#if defined(IRCMSG_SCAN_X86)
+	__builtin_cpu_init();
+#endif
+	size_t level = LEVEL_COUNT - 1;
+	const char *forced = getenv("IRCMSG_SIMD");
+	if (forced != NULL) {
+		for (size_t i = 0; i < LEVEL_COUNT; ++i) {
+			if (strcmp(forced, level_names[i]) == 0) level = i;
+		}
+	}
+	while (!ircmsg_simd_set_level((ircmsg_simd_level) level)) --level;
+}
+
+#else
+
+ircmsg_simd_level
+ircmsg_simd_get_level(void)
+{
+#if defined(IRCMSG_SCAN_X86) && defined(__AVX512BW__)
+	return IRCMSG_SIMD_AVX512;
+#elif defined(IRCMSG_SCAN_X86) && defined(__AVX2__)
+	return IRCMSG_SIMD_AVX2;
+#elif defined(IRCMSG_SCAN_X86) && defined(__SSE2__)
+	return IRCMSG_SIMD_SSE2;
+#else
+	return IRCMSG_SIMD_SCALAR;
+#endif
+}
+
+bool
+ircmsg_simd_set_level(ircmsg_simd_level level)
+{
+	return level == ircmsg_simd_get_level();
+}
+
+#endif /* IRCMSG_SCAN_DISPATCH */
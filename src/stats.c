@@ -0,0 +1,75 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include "ircmsg/stats.h"
+#include "stats_counters.h"
+#include <string.h>
+
+#ifdef IRCMSG_STATS
+
+ircmsg_stats ircmsg_stats_counters;
+
+// Every counter is a uint64_t, so the struct can be gone through as an
+// array of them.
+#define COUNTER_COUNT (sizeof(ircmsg_stats) / sizeof(uint64_t))
+
+bool
+ircmsg_stats_snapshot(ircmsg_stats *stats)
+{
+	const uint64_t *from = (const uint64_t *) &ircmsg_stats_counters;
+	uint64_t *to = (uint64_t *) stats;
+	for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+#if defined(__GNUC__)
+		to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+#else
+		to[i] = from[i];
+#endif
+	}
+	return true;
+}
+
+void
+ircmsg_stats_reset(void)
+{
+	uint64_t *counters = (uint64_t *) &ircmsg_stats_counters;
+	for (size_t i = 0; i < COUNTER_COUNT; ++i) {
+#if defined(__GNUC__)
+		__atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+#else
+		counters[i] = 0;
+#endif
+	}
+}
+
+#else
+
+bool
+ircmsg_stats_snapshot(ircmsg_stats *stats)
+{
+	memset(stats, 0, sizeof(*stats));
+	return false;
+}
+
+void
+ircmsg_stats_reset(void)
+{
+}
+
+#endif /* IRCMSG_STATS */
@@ -0,0 +1,81 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+// The counters behind <ircmsg/stats.h>. Everything in here turns into
+// nothing unless the library is built with IRCMSG_STATS defined, so
+// that the parser and the serializer don't pay for them otherwise.
+
+#ifndef __STATS_COUNTERS_H_
+#define __STATS_COUNTERS_H_
+
+#include <ircmsg/stats.h>
+
+#ifdef IRCMSG_STATS
+
+extern ircmsg_stats ircmsg_stats_counters;
+
+// The counters may be updated from several threads at once, each of
+// them parsing messages of its own.
+#if defined(__GNUC__)
+#define IRCMSG_STATS_ADD(counter, n)						\
+	((void) __atomic_fetch_add(&ircmsg_stats_counters.counter,		\
+				   (uint64_t) (n), __ATOMIC_RELAXED))
+#else
+#define IRCMSG_STATS_ADD(counter, n)						\
+	((void) (ircmsg_stats_counters.counter += (uint64_t) (n)))
+#endif
+
+static inline void
+ircmsg_stats_count_message(size_t len, size_t tag_count, size_t param_count)
+{
+	IRCMSG_STATS_ADD(messages, 1);
+	IRCMSG_STATS_ADD(bytes, len);
+	IRCMSG_STATS_ADD(message_lengths[ircmsg_stats_length_bucket(len)], 1);
+	IRCMSG_STATS_ADD(tags_per_message[ircmsg_stats_count_bucket(tag_count)], 1);
+	IRCMSG_STATS_ADD(params_per_message[ircmsg_stats_count_bucket(param_count)], 1);
+}
+
+// The parser's share, given its `ircmsg_parser_state`, which holds the
+// counts for the message being parsed.
+#define IRCMSG_STATS_START_MESSAGE(st)						\
+	((st)->tag_count = 0, (st)->param_count = 0)
+#define IRCMSG_STATS_TAG(st, name_len, value_len)				\
+	(++(st)->tag_count,							\
+	 IRCMSG_STATS_ADD(tag_lengths[ircmsg_stats_length_bucket(		\
+		 (name_len) + (value_len))], 1))
+#define IRCMSG_STATS_PARAM(st, len)						\
+	(++(st)->param_count,							\
+	 IRCMSG_STATS_ADD(param_lengths[ircmsg_stats_length_bucket(len)], 1))
+#define IRCMSG_STATS_END_MESSAGE(st, len)					\
+	ircmsg_stats_count_message((len), (st)->tag_count, (st)->param_count)
+#define IRCMSG_STATS_ERROR(error) IRCMSG_STATS_ADD(errors[(error)], 1)
+
+#else
+
+#define IRCMSG_STATS_ADD(counter, n) ((void) 0)
+#define IRCMSG_STATS_START_MESSAGE(st) ((void) 0)
+#define IRCMSG_STATS_TAG(st, name_len, value_len) ((void) 0)
+#define IRCMSG_STATS_PARAM(st, len) ((void) 0)
+#define IRCMSG_STATS_END_MESSAGE(st, len) ((void) 0)
+#define IRCMSG_STATS_ERROR(error) ((void) 0)
+
+#endif /* IRCMSG_STATS */
+
+#endif /* __STATS_COUNTERS_H_ */
@@ -0,0 +1,99 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <ircmsg/command.h>
+
+static ircmsg_command_id
+classify(const char *command)
+{
+	return ircmsg_command_classify((const uint8_t *) command,
+				       strlen(command));
+}
+
+static void
+test_named (void **state)
+{
+	assert_int_equal(classify("PRIVMSG"), IRCMSG_CMD_PRIVMSG);
+	assert_int_equal(classify("NOTICE"), IRCMSG_CMD_NOTICE);
+	assert_int_equal(classify("PING"), IRCMSG_CMD_PING);
+	assert_int_equal(classify("PONG"), IRCMSG_CMD_PONG);
+	assert_int_equal(classify("JOIN"), IRCMSG_CMD_JOIN);
+	assert_int_equal(classify("WHO"), IRCMSG_CMD_WHO);
+	assert_int_equal(classify("WHOIS"), IRCMSG_CMD_WHOIS);
+	assert_int_equal(classify("WHOWAS"), IRCMSG_CMD_WHOWAS);
+	assert_int_equal(classify("CAP"), IRCMSG_CMD_CAP);
+	assert_int_equal(classify("AUTHENTICATE"), IRCMSG_CMD_AUTHENTICATE);
+	assert_int_equal(classify("TAGMSG"), IRCMSG_CMD_TAGMSG);
+	assert_int_equal(classify("WEBIRC"), IRCMSG_CMD_WEBIRC);
+}
+
+static void
+test_case_insensitive (void **state)
+{
+	assert_int_equal(classify("privmsg"), IRCMSG_CMD_PRIVMSG);
+	assert_int_equal(classify("Ping"), IRCMSG_CMD_PING);
+	assert_int_equal(classify("cAp"), IRCMSG_CMD_CAP);
+}
+
+static void
+test_numeric (void **state)
+{
+	assert_int_equal(classify("001"), 1);
+	assert_int_equal(classify("433"), 433);
+	assert_int_equal(classify("999"), 999);
+	assert_int_equal(classify("000"), 0);
+	assert_true(IRCMSG_CMD_IS_NUMERIC(classify("372")));
+	assert_false(IRCMSG_CMD_IS_NUMERIC(classify("PING")));
+
+	assert_int_equal(classify("01"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("0001"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("4x3"), IRCMSG_CMD_UNKNOWN);
+}
+
+static void
+test_unknown (void **state)
+{
+	assert_int_equal(classify(""), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("PRIVMSX"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("PRIV"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("PRIVMSGS"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("P\x10NG"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("AUTHENTICATED"), IRCMSG_CMD_UNKNOWN);
+	assert_int_equal(classify("FOOBAR"), IRCMSG_CMD_UNKNOWN);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_named),
+		cmocka_unit_test(test_case_insensitive),
+		cmocka_unit_test(test_numeric),
+		cmocka_unit_test(test_unknown),
+	};
+
+	return cmocka_run_group_tests_name("command_test", tests, NULL, NULL);
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+
+# Copyright (c) 2019 Jani Juhani Sinervo
+#
+# Permission is hereby granted, free of charge, to any person obtaining a copy
+# of this software and associated documentation files (the "Software"), to deal
+# in the Software without restriction, including without limitation the rights
+# to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+# copies of the Software, and to permit persons to whom the Software is
+# furnished to do so, subject to the following conditions:
+
+# The above copyright notice and this permission notice shall be included in all
+# copies or substantial portions of the Software.
+
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+# IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+# FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+# AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+# LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+# OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+# SOFTWARE.
+
+import yaml
+import sys
+
+def c_escape(string):
+    ret = ''
+    for c in string:
+        if c in '\\"?':
+            ret = ret + '\\' + c
+        elif c == '\r':
+            ret = ret + '\\r'
+        elif c == '\n':
+            ret = ret + '\\n'
+        else:
+            ret = ret + c
+    return ret
+
+tests = None
+
+with open(sys.argv[1], 'r') as test_file:
+    tests = yaml.safe_load(test_file)['tests']
+
+inputs = ',\n'.join(f'\t"{c_escape(test["input"])}"' for test in tests)
+
+with open(sys.argv[2], 'r') as template:
+    contents = template.read().format(inputs=inputs)
+    with open(sys.argv[3], 'w') as output:
+        output.write(contents)
@@ -0,0 +1,197 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/dispatch.h>
+
+struct calls
+{
+	size_t privmsg;
+	size_t welcome;
+	size_t unknown;
+	size_t fallback;
+	char last_param[32];
+};
+
+static void
+on_privmsg(const uint8_t *buf, const ircmsg_message_view *view,
+	   void *user_data)
+{
+	struct calls *calls = user_data;
+	++calls->privmsg;
+
+	assert_int_equal(view->command_id, IRCMSG_CMD_PRIVMSG);
+	assert_int_equal(view->param_count, 2);
+	const ircmsg_span *text = &view->params[1];
+	assert_true(text->len < sizeof(calls->last_param));
+	memcpy(calls->last_param, buf + text->offset, text->len);
+	calls->last_param[text->len] = '\0';
+}
+
+static void
+on_welcome(const uint8_t *buf, const ircmsg_message_view *view,
+	   void *user_data)
+{
+	struct calls *calls = user_data;
+	++calls->welcome;
+	assert_int_equal(view->command_id, 1);
+}
+
+static void
+on_unknown(const uint8_t *buf, const ircmsg_message_view *view,
+	   void *user_data)
+{
+	struct calls *calls = user_data;
+	++calls->unknown;
+	assert_int_equal(view->command_id, IRCMSG_CMD_UNKNOWN);
+}
+
+static void
+on_anything(const uint8_t *buf, const ircmsg_message_view *view,
+	    void *user_data)
+{
+	struct calls *calls = user_data;
+	++calls->fallback;
+}
+
+static const ircmsg_dispatch_table table = {
+	.handlers = {
+		[IRCMSG_CMD_PRIVMSG] = on_privmsg,
+		[1] = on_welcome,
+	},
+	.fallback = on_anything,
+};
+
+static const char *traffic =
+	":irc.example.com 001 nick :Welcome\r\n"
+	":a!a@a PRIVMSG #chan :hello\r\n"
+	":a!a@a JOIN #chan\r\n"
+	"XYZZY foo\r\n"
+	":a!a@a privmsg #chan :again\r\n"
+	"PING :incomplete";
+
+static void
+test_dispatch (void **state)
+{
+	ircmsg_span params[8];
+	ircmsg_message_view view = { .params = params, .params_cap = 8 };
+	struct calls calls = { .privmsg = 0 };
+
+	const char *msg = ":a!a@a PRIVMSG #chan :hello there\r\n";
+	size_t consumed = ircmsg_dispatch(&table, (const uint8_t *) msg,
+					  strlen(msg), &view, &calls);
+	assert_int_equal(consumed, strlen(msg));
+	assert_int_equal(calls.privmsg, 1);
+	assert_string_equal(calls.last_param, "hello there");
+
+	// Nothing is dispatched for a message that fails to parse.
+	msg = ":a!a@a\r\n";
+	consumed = ircmsg_dispatch(&table, (const uint8_t *) msg,
+				   strlen(msg), &view, &calls);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(calls.privmsg + calls.fallback, 1);
+}
+
+static void
+test_dispatch_batch (void **state)
+{
+	ircmsg_span params[8];
+	ircmsg_message_view view = { .params = params, .params_cap = 8 };
+	struct calls calls = { .privmsg = 0 };
+
+	size_t consumed = ircmsg_dispatch_batch(&table, (const uint8_t *) traffic,
+						strlen(traffic), &view, &calls);
+	assert_int_equal(consumed, strlen(traffic) - strlen("PING :incomplete"));
+	assert_int_equal(calls.welcome, 1);
+	assert_int_equal(calls.privmsg, 2);
+	assert_int_equal(calls.fallback, 2);
+	assert_string_equal(calls.last_param, "again");
+}
+
+static void
+test_unknown_slot (void **state)
+{
+	ircmsg_span params[8];
+	ircmsg_message_view view = { .params = params, .params_cap = 8 };
+	struct calls calls = { .privmsg = 0 };
+
+	// Without a fallback, commands nobody handles are dropped.
+	ircmsg_dispatch_table unknown_only = { .fallback = NULL };
+	unknown_only.handlers[IRCMSG_CMD_UNKNOWN] = on_unknown;
+
+	size_t consumed = ircmsg_dispatch_batch(&unknown_only,
+						(const uint8_t *) traffic,
+						strlen(traffic), &view, &calls);
+	assert_int_equal(consumed, strlen(traffic) - strlen("PING :incomplete"));
+	assert_int_equal(calls.unknown, 1);
+	assert_int_equal(calls.privmsg + calls.welcome + calls.fallback, 0);
+}
+
+static void
+test_limits (void **state)
+{
+	ircmsg_span params[8];
+	ircmsg_message_view view = { .params = params, .params_cap = 8 };
+	struct calls calls = { .privmsg = 0 };
+	const ircmsg_parser_limits limits = {
+		.max_tags_len = IRCMSG_PARSER_MAX_TAGS_LEN,
+		.max_body_len = 20,
+	};
+
+	const char *msg = "PRIVMSG #a :short\r\nPRIVMSG #a :this one is too long\r\n";
+	size_t consumed = ircmsg_dispatch_ex(&table, (const uint8_t *) msg,
+					     strlen(msg), &view, &calls, &limits);
+	assert_int_equal(consumed, strlen("PRIVMSG #a :short\r\n"));
+	assert_int_equal(calls.privmsg, 1);
+
+	// The batch stops at the message over the limit, without
+	// handing it to anyone.
+	consumed = ircmsg_dispatch_batch_ex(&table, (const uint8_t *) msg,
+					    strlen(msg), &view, &calls, &limits);
+	assert_int_equal(consumed, strlen("PRIVMSG #a :short\r\n"));
+	assert_int_equal(calls.privmsg, 2);
+	assert_int_equal(view.error, IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+	assert_string_equal(calls.last_param, "short");
+
+	// Without limits, the defaults apply.
+	consumed = ircmsg_dispatch_batch_ex(&table, (const uint8_t *) msg,
+					    strlen(msg), &view, &calls, NULL);
+	assert_int_equal(consumed, strlen(msg));
+	assert_int_equal(calls.privmsg, 4);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_dispatch),
+		cmocka_unit_test(test_dispatch_batch),
+		cmocka_unit_test(test_unknown_slot),
+		cmocka_unit_test(test_limits),
+	};
+
+	return cmocka_run_group_tests_name("dispatch_test", tests, NULL, NULL);
+}
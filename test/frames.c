@@ -0,0 +1,119 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+
+static void
+test_terminators (void **state)
+{
+	const char *buf = "PING a\r\nPING b\n\rPING c\nPING d\rPING e\r\n";
+	size_t ends[8];
+	bool invalid;
+
+	size_t count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+					  ends, 8, &invalid);
+	assert_false(invalid);
+	assert_int_equal(count, 5);
+	assert_int_equal(ends[0], 8);
+	assert_int_equal(ends[1], 16);
+	assert_int_equal(ends[2], 23);
+	assert_int_equal(ends[3], 30);
+	assert_int_equal(ends[4], strlen(buf));
+}
+
+static void
+test_incomplete (void **state)
+{
+	size_t ends[4];
+	bool invalid;
+
+	// The CR may be followed by an LF later on.
+	const char *buf = "PING a\r\nPING b\r";
+	size_t count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+					  ends, 4, &invalid);
+	assert_false(invalid);
+	assert_int_equal(count, 1);
+	assert_int_equal(ends[0], 8);
+
+	// But this one finishes an LFCR.
+	buf = "PING a\n\r";
+	count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+				   ends, 4, &invalid);
+	assert_int_equal(count, 1);
+	assert_int_equal(ends[0], 8);
+
+	buf = "PING a\r\nPING b";
+	count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+				   ends, 4, &invalid);
+	assert_int_equal(count, 1);
+}
+
+static void
+test_invalid (void **state)
+{
+	const char *buf = "PING a\r\nPING b\r\rPING c\r\n";
+	size_t ends[4];
+	bool invalid;
+
+	size_t count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+					  ends, 4, &invalid);
+	assert_true(invalid);
+	assert_int_equal(count, 1);
+
+	buf = "PING a\n\n";
+	count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+				   ends, 4, &invalid);
+	assert_true(invalid);
+	assert_int_equal(count, 0);
+}
+
+static void
+test_cap (void **state)
+{
+	const char *buf = "PING a\r\nPING b\r\nPING c\r\n";
+	size_t ends[2];
+	bool invalid;
+
+	size_t count = ircmsg_find_frames((const uint8_t *) buf, strlen(buf),
+					  ends, 2, &invalid);
+	assert_false(invalid);
+	assert_int_equal(count, 2);
+	assert_int_equal(ends[1], 16);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_terminators),
+		cmocka_unit_test(test_incomplete),
+		cmocka_unit_test(test_invalid),
+		cmocka_unit_test(test_cap),
+	};
+
+	return cmocka_run_group_tests_name("frames_test", tests, NULL, NULL);
+}
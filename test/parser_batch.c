@@ -0,0 +1,259 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <stdio.h>
+
+struct batch_test
+{
+	size_t messages;
+	size_t errors;
+	char commands[256];
+};
+
+static void
+batch_nop(void *user_data)
+{
+	(void) user_data;
+}
+
+static void
+batch_on_tag(const uint8_t *name, size_t name_len,
+	     const uint8_t *esc_value, size_t esc_value_len,
+	     void *user_data)
+{
+	(void) name; (void) name_len;
+	(void) esc_value; (void) esc_value_len;
+	(void) user_data;
+}
+
+static void
+batch_on_token(const uint8_t *token, size_t token_len, void *user_data)
+{
+	(void) token; (void) token_len;
+	(void) user_data;
+}
+
+static void
+batch_on_command(const uint8_t *command, size_t command_len,
+		 void *user_data)
+{
+	struct batch_test *test = user_data;
+	strncat(test->commands, (const char *) command, command_len);
+	strcat(test->commands, ",");
+}
+
+static void
+batch_end_message(void *user_data)
+{
+	struct batch_test *test = user_data;
+	++test->messages;
+}
+
+static void
+batch_on_error(ircmsg_parser_err_code error, void *user_data)
+{
+	struct batch_test *test = user_data;
+	(void) error;
+	++test->errors;
+}
+
+static ircmsg_parser_callbacks batch_cbs = {
+	.start_message = batch_nop,
+	.start_tags = batch_nop,
+	.on_tag = batch_on_tag,
+	.end_tags = batch_nop,
+	.on_prefix = batch_on_token,
+	.on_command = batch_on_command,
+	.start_params = batch_nop,
+	.on_param = batch_on_token,
+	.end_params = batch_nop,
+	.end_message = batch_end_message,
+	.on_error = batch_on_error,
+};
+
+static int
+batch_setup (void **state)
+{
+	struct batch_test *test = calloc(1, sizeof(*test));
+	if (test == NULL) {
+		return -1;
+	}
+	*state = test;
+	return 0;
+}
+
+static int
+batch_teardown (void **state)
+{
+	free(*state);
+	return 0;
+}
+
+static void
+test_complete (void **state)
+{
+	struct batch_test *test = *state;
+	const char *batch_str =
+		"@time=now :a!b@c PRIVMSG #test :hello there\r\n"
+		"PING :server\n"
+		":server 353 me = #test :a b c\r\n";
+	size_t consumed = ircmsg_parse_batch((const uint8_t *) batch_str,
+					     strlen(batch_str),
+					     &batch_cbs,
+					     test);
+	assert_int_equal(consumed, strlen(batch_str));
+	assert_int_equal(test->messages, 3);
+	assert_int_equal(test->errors, 0);
+	assert_string_equal(test->commands, "PRIVMSG,PING,353,");
+}
+
+static void
+test_partial (void **state)
+{
+	struct batch_test *test = *state;
+	const char *complete_str = "PING :a\r\nPING :b\r\n";
+	const char *batch_str = "PING :a\r\nPING :b\r\n:server PRIVMSG #test :hel";
+	size_t consumed = ircmsg_parse_batch((const uint8_t *) batch_str,
+					     strlen(batch_str),
+					     &batch_cbs,
+					     test);
+	assert_int_equal(consumed, strlen(complete_str));
+	assert_int_equal(test->messages, 2);
+	assert_int_equal(test->errors, 0);
+}
+
+static void
+test_partial_crlf (void **state)
+{
+	struct batch_test *test = *state;
+	const char *complete_str = "PING :a\r\n";
+	const char *batch_str = "PING :a\r\nPING :b\r";
+	size_t consumed = ircmsg_parse_batch((const uint8_t *) batch_str,
+					     strlen(batch_str),
+					     &batch_cbs,
+					     test);
+	assert_int_equal(consumed, strlen(complete_str));
+	assert_int_equal(test->messages, 1);
+}
+
+static void
+test_error_stops (void **state)
+{
+	struct batch_test *test = *state;
+	const char *complete_str = "PING :a\r\n";
+	const char *batch_str = "PING :a\r\n@foo\r\nPING :b\r\n";
+	size_t consumed = ircmsg_parse_batch((const uint8_t *) batch_str,
+					     strlen(batch_str),
+					     &batch_cbs,
+					     test);
+	assert_int_equal(consumed, strlen(complete_str));
+	assert_int_equal(test->messages, 1);
+	assert_int_equal(test->errors, 1);
+}
+
+static void
+test_recover (void **state)
+{
+	struct batch_test *test = *state;
+	const char *batch_str =
+		"PING :a\r\n"
+		"@foo\r\n"
+		"PING :b\r\r"
+		"\r\n"
+		":only.a.prefix\n"
+		"PING :c\r\n"
+		"PING :d";
+	ircmsg_parser_error_counts errors = { { 0 } };
+	size_t consumed = ircmsg_parse_batch_recover((const uint8_t *) batch_str,
+						     strlen(batch_str),
+						     &batch_cbs,
+						     test,
+						     &errors);
+	assert_int_equal(consumed, strlen(batch_str) - strlen("PING :d"));
+	assert_int_equal(test->messages, 2);
+	assert_int_equal(test->errors, 3);
+	assert_string_equal(test->commands, "PING,PING,PING,");
+	assert_int_equal(errors.counts[IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE], 2);
+	assert_int_equal(errors.counts[IRCMSG_ERR_PARSER_INVALID_SENTINEL], 1);
+	assert_int_equal(errors.counts[IRCMSG_ERR_PARSER_MESSAGE_NOT_FOUND], 0);
+}
+
+static void
+test_recover_too_long (void **state)
+{
+	struct batch_test *test = *state;
+
+	// The message is found to be too long well before its terminator,
+	// which is where the next one still has to be looked for.
+	char batch_str[1024] = "PRIVMSG #chan :";
+	size_t len = strlen(batch_str);
+	while (len < 700) {
+		memcpy(batch_str + len, "hi :@; ", 7);
+		len += 7;
+	}
+	strcpy(batch_str + len, "\r\nPING :next\r\n");
+
+	ircmsg_parser_error_counts errors = { { 0 } };
+	size_t consumed = ircmsg_parse_batch_recover((const uint8_t *) batch_str,
+						     strlen(batch_str),
+						     &batch_cbs,
+						     test,
+						     &errors);
+	assert_int_equal(consumed, strlen(batch_str));
+	assert_int_equal(test->messages, 1);
+	assert_int_equal(test->errors, 1);
+	assert_string_equal(test->commands, "PRIVMSG,PING,");
+	assert_int_equal(errors.counts[IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG], 1);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_complete,
+						batch_setup,
+						batch_teardown),
+		cmocka_unit_test_setup_teardown(test_partial,
+						batch_setup,
+						batch_teardown),
+		cmocka_unit_test_setup_teardown(test_partial_crlf,
+						batch_setup,
+						batch_teardown),
+		cmocka_unit_test_setup_teardown(test_error_stops,
+						batch_setup,
+						batch_teardown),
+		cmocka_unit_test_setup_teardown(test_recover,
+						batch_setup,
+						batch_teardown),
+		cmocka_unit_test_setup_teardown(test_recover_too_long,
+						batch_setup,
+						batch_teardown),
+	};
+
+	return cmocka_run_group_tests_name("parse_batch_test", tests, NULL, NULL);
+}
@@ -0,0 +1,323 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+
+struct router
+{
+	// The command whose messages are skipped or aborted on.
+	const char *drop;
+	ircmsg_parser_control on_drop;
+	ircmsg_parser_control on_start;
+	ircmsg_parser_control on_tag;
+	bool abort_on_end;
+
+	size_t starts;
+	size_t tag_sections;
+	size_t tags;
+	size_t commands;
+	size_t params;
+	size_t messages;
+	size_t errors;
+};
+
+static ircmsg_parser_control
+route_start(void *user_data)
+{
+	struct router *router = user_data;
+	++router->starts;
+	return router->on_start;
+}
+
+static ircmsg_parser_control
+count_tags(void *user_data)
+{
+	struct router *router = user_data;
+	++router->tag_sections;
+	return IRCMSG_PARSER_CONTINUE;
+}
+
+static ircmsg_parser_control
+count_tag(const uint8_t *name, size_t name_len,
+	  const uint8_t *value, size_t value_len,
+	  void *user_data)
+{
+	struct router *router = user_data;
+	++router->tags;
+	return router->on_tag;
+}
+
+static ircmsg_parser_control
+route_command(const uint8_t *command, size_t command_len, void *user_data)
+{
+	struct router *router = user_data;
+	++router->commands;
+	if (router->drop && strlen(router->drop) == command_len &&
+	    memcmp(router->drop, command, command_len) == 0) {
+		return router->on_drop;
+	}
+	return IRCMSG_PARSER_CONTINUE;
+}
+
+static ircmsg_parser_control
+count_param(const uint8_t *param, size_t param_len, void *user_data)
+{
+	struct router *router = user_data;
+	++router->params;
+	return IRCMSG_PARSER_CONTINUE;
+}
+
+static ircmsg_parser_control
+count_message(void *user_data)
+{
+	struct router *router = user_data;
+	++router->messages;
+	return router->abort_on_end ? IRCMSG_PARSER_ABORT : IRCMSG_PARSER_CONTINUE;
+}
+
+static void
+count_error(ircmsg_parser_err_code err, void *user_data)
+{
+	struct router *router = user_data;
+	++router->errors;
+}
+
+// Only the callbacks of interest are given.
+static const ircmsg_parser_control_callbacks router_callbacks = {
+	.start_message = route_start,
+	.start_tags = count_tags,
+	.on_tag = count_tag,
+	.on_command = route_command,
+	.on_param = count_param,
+	.end_message = count_message,
+	.on_error = count_error,
+};
+
+static const char *traffic =
+	"@time=1 :a!a@a JOIN #chan\r\n"
+	"@time=2 :b!b@b PRIVMSG #chan :hello there\r\n"
+	"@time=3 :c!c@c PART #chan :bye\r\n"
+	"@time=4 :d!d@d PRIVMSG #chan :hi\r\n";
+
+static void
+test_continue (void **state)
+{
+	struct router router = { .drop = NULL };
+
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) traffic,
+							strlen(traffic),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, strlen(traffic));
+	assert_int_equal(router.tags, 4);
+	assert_int_equal(router.commands, 4);
+	assert_int_equal(router.params, 7);
+	assert_int_equal(router.messages, 4);
+	assert_int_equal(router.errors, 0);
+}
+
+static void
+test_skip (void **state)
+{
+	struct router router = {
+		.drop = "PRIVMSG",
+		.on_drop = IRCMSG_PARSER_SKIP_MESSAGE,
+	};
+
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) traffic,
+							strlen(traffic),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, strlen(traffic));
+	assert_int_equal(router.commands, 4);
+	assert_int_equal(router.params, 3);
+	assert_int_equal(router.messages, 2);
+	assert_int_equal(router.errors, 0);
+
+	// A skipped message doesn't have to be valid past the point it
+	// was skipped at, but the terminator still has to be.
+	const char *bad = "PING x\r\nPRIVMSG #chan :a\r\rPING y\r\n";
+	memset(&router, 0, sizeof(router));
+	router.drop = "PRIVMSG";
+	router.on_drop = IRCMSG_PARSER_SKIP_MESSAGE;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) bad,
+						 strlen(bad),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, 8);
+	assert_int_equal(router.messages, 1);
+	assert_int_equal(router.errors, 1);
+}
+
+static void
+test_abort (void **state)
+{
+	struct router router = {
+		.drop = "PART",
+		.on_drop = IRCMSG_PARSER_ABORT,
+	};
+
+	// Aborting in the middle of a message leaves it unconsumed.
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) traffic,
+							strlen(traffic),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, strlen(traffic) - strlen(strstr(traffic, "@time=3")));
+	assert_int_equal(router.commands, 3);
+	assert_int_equal(router.messages, 2);
+	assert_int_equal(router.errors, 0);
+
+	// But not once it's complete.
+	memset(&router, 0, sizeof(router));
+	router.abort_on_end = true;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) traffic,
+						 strlen(traffic),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, strlen(traffic) - strlen(strstr(traffic, "@time=2")));
+	assert_int_equal(router.messages, 1);
+}
+
+static void
+test_control_at_terminator (void **state)
+{
+	// The command is the last thing before the terminator, so the
+	// control it asks for has to be taken before ending the message.
+	const char *ping = "PING\r\n";
+	struct router router = {
+		.drop = "PING",
+		.on_drop = IRCMSG_PARSER_ABORT,
+	};
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) ping,
+							strlen(ping),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(router.commands, 1);
+	assert_int_equal(router.messages, 0);
+
+	memset(&router, 0, sizeof(router));
+	router.drop = "PING";
+	router.on_drop = IRCMSG_PARSER_SKIP_MESSAGE;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) ping,
+						 strlen(ping),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, strlen(ping));
+	assert_int_equal(router.commands, 1);
+	assert_int_equal(router.messages, 0);
+	assert_int_equal(router.errors, 0);
+
+	// Likewise for the last parameter.
+	const char *part = "PART #chan :bye\r\n";
+	memset(&router, 0, sizeof(router));
+	router.drop = "PART";
+	router.on_drop = IRCMSG_PARSER_SKIP_MESSAGE;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) part,
+						 strlen(part),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, strlen(part));
+	assert_int_equal(router.params, 0);
+	assert_int_equal(router.messages, 0);
+}
+
+static void
+test_control_at_tags (void **state)
+{
+	// The start of the message and of its tags are reported for the
+	// same byte, but nothing may follow an abort.
+	const char *tagged = "@a=1 PING\r\n";
+	struct router router = { .on_start = IRCMSG_PARSER_ABORT };
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) tagged,
+							strlen(tagged),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(router.starts, 1);
+	assert_int_equal(router.tag_sections, 0);
+	assert_int_equal(router.tags, 0);
+	assert_int_equal(router.commands, 0);
+
+	// Nor a skip.
+	memset(&router, 0, sizeof(router));
+	router.on_start = IRCMSG_PARSER_SKIP_MESSAGE;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) tagged,
+						 strlen(tagged),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, strlen(tagged));
+	assert_int_equal(router.tag_sections, 0);
+	assert_int_equal(router.tags, 0);
+	assert_int_equal(router.messages, 0);
+}
+
+static void
+test_skip_long_tags (void **state)
+{
+	// The rest of the tags may be longer than the limit on the body,
+	// and still be skipped.
+	char tagged[1024] = "@a=1;b=";
+	size_t len = strlen(tagged);
+	memset(tagged + len, 'x', 700);
+	strcpy(tagged + len + 700, " PRIVMSG #chan :hi\r\nPING\r\n");
+
+	struct router router = { .on_tag = IRCMSG_PARSER_SKIP_MESSAGE };
+	size_t consumed = ircmsg_parse_batch_controlled((const uint8_t *) tagged,
+							strlen(tagged),
+							&router_callbacks,
+							&router);
+	assert_int_equal(consumed, strlen(tagged));
+	assert_int_equal(router.tags, 1);
+	assert_int_equal(router.commands, 1);
+	assert_int_equal(router.messages, 1);
+	assert_int_equal(router.errors, 0);
+
+	// While the body is still held to its own limit, from where the
+	// tags end.
+	strcpy(tagged, "@a=1;b=x PRIVMSG #chan :");
+	len = strlen(tagged);
+	memset(tagged + len, 'y', 600);
+	strcpy(tagged + len + 600, "\r\n");
+	memset(&router, 0, sizeof(router));
+	router.on_tag = IRCMSG_PARSER_SKIP_MESSAGE;
+	consumed = ircmsg_parse_batch_controlled((const uint8_t *) tagged,
+						 strlen(tagged),
+						 &router_callbacks, &router);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(router.errors, 1);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_continue),
+		cmocka_unit_test(test_skip),
+		cmocka_unit_test(test_abort),
+		cmocka_unit_test(test_control_at_terminator),
+		cmocka_unit_test(test_control_at_tags),
+		cmocka_unit_test(test_skip_long_tags),
+	};
+
+	return cmocka_run_group_tests_name("control_test", tests, NULL, NULL);
+}
@@ -104,6 +104,110 @@ test_tags_unexpected_end (void **state)
 	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
 }
 
+static void
+test_body_limit (void **state)
+{
+	struct irc_test *test_struct = *state;
+	uint8_t msg[IRCMSG_PARSER_MAX_BODY_LEN];
+	memset(msg, 'a', sizeof(msg));
+	memcpy(msg, "PRIVMSG #chan :", strlen("PRIVMSG #chan :"));
+	memcpy(msg + sizeof(msg) - 2, "\r\n", 2);
+
+	// Right at the limit, CRLF included.
+	size_t consumed = ircmsg_parse(msg, sizeof(msg), &test_cbs, test_struct);
+	assert_int_equal(consumed, sizeof(msg));
+	assert_false(test_struct->failed);
+}
+
+static void
+test_body_too_long (void **state)
+{
+	struct irc_test *test_struct = *state;
+	uint8_t msg[IRCMSG_PARSER_MAX_BODY_LEN + 1];
+	memset(msg, 'a', sizeof(msg));
+	memcpy(msg, "PRIVMSG #chan :", strlen("PRIVMSG #chan :"));
+	memcpy(msg + sizeof(msg) - 2, "\r\n", 2);
+
+	size_t consumed = ircmsg_parse(msg, sizeof(msg), &test_cbs, test_struct);
+	assert_int_equal(consumed, 0);
+	assert_true(test_struct->failed);
+	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+}
+
+static void
+test_tags_too_long (void **state)
+{
+	struct irc_test *test_struct = *state;
+	const char *rest = " PING\r\n";
+	uint8_t msg[IRCMSG_PARSER_MAX_TAGS_LEN + 8];
+	memset(msg, 'a', sizeof(msg));
+	msg[0] = '@';
+	memcpy(msg + sizeof(msg) - strlen(rest), rest, strlen(rest));
+
+	size_t consumed = ircmsg_parse(msg, sizeof(msg), &test_cbs, test_struct);
+	assert_int_equal(consumed, 0);
+	assert_true(test_struct->failed);
+	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+}
+
+static void
+test_limits_ex (void **state)
+{
+	struct irc_test *test_struct = *state;
+	uint8_t msg[IRCMSG_PARSER_MAX_BODY_LEN + 1];
+	memset(msg, 'a', sizeof(msg));
+	memcpy(msg, "PRIVMSG #chan :", strlen("PRIVMSG #chan :"));
+	memcpy(msg + sizeof(msg) - 2, "\r\n", 2);
+
+	// Lifting the limits lets through what the defaults don't.
+	const ircmsg_parser_limits lifted = {
+		.max_tags_len = SIZE_MAX,
+		.max_body_len = SIZE_MAX,
+	};
+	size_t consumed = ircmsg_parse_ex(msg, sizeof(msg), &test_cbs,
+					  test_struct, &lifted);
+	assert_int_equal(consumed, sizeof(msg));
+	assert_false(test_struct->failed);
+	free_msg(test_struct->msg);
+	test_struct->msg = NULL;
+
+	consumed = ircmsg_parse_batch_ex(msg, sizeof(msg), &test_cbs,
+					 test_struct, &lifted);
+	assert_int_equal(consumed, sizeof(msg));
+	assert_false(test_struct->failed);
+	free_msg(test_struct->msg);
+	test_struct->msg = NULL;
+
+	consumed = ircmsg_parse_segments_ex(msg, sizeof(msg), msg + sizeof(msg),
+					    0, &test_cbs, NULL, test_struct,
+					    &lifted);
+	assert_int_equal(consumed, sizeof(msg));
+	assert_false(test_struct->failed);
+	free_msg(test_struct->msg);
+	test_struct->msg = NULL;
+
+	// And lowering them rejects what the defaults let through.
+	const ircmsg_parser_limits lowered = {
+		.max_tags_len = IRCMSG_PARSER_MAX_TAGS_LEN,
+		.max_body_len = 8,
+	};
+	const char *ping = "PING :irc.example.com\r\n";
+	ircmsg_parser_error_counts errors = { { 0 } };
+	consumed = ircmsg_parse_batch_recover_ex((const uint8_t *) ping,
+						 strlen(ping), &test_cbs,
+						 test_struct, &errors, &lowered);
+	assert_int_equal(consumed, strlen(ping));
+	assert_true(test_struct->failed);
+	assert_int_equal(errors.counts[IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG], 1);
+
+	// NULL stands for the defaults.
+	test_struct->failed = false;
+	consumed = ircmsg_parse_ex(msg, sizeof(msg), &test_cbs, test_struct,
+				   NULL);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -120,6 +224,18 @@ main (int argc, char **argv)
 		cmocka_unit_test_setup_teardown(test_tags_unexpected_end,
 						failure_setup,
 						failure_teardown),
+		cmocka_unit_test_setup_teardown(test_body_limit,
+						failure_setup,
+						failure_teardown),
+		cmocka_unit_test_setup_teardown(test_body_too_long,
+						failure_setup,
+						failure_teardown),
+		cmocka_unit_test_setup_teardown(test_tags_too_long,
+						failure_setup,
+						failure_teardown),
+		cmocka_unit_test_setup_teardown(test_limits_ex,
+						failure_setup,
+						failure_teardown),
 	};
 
 	return cmocka_run_group_tests_name("parse_fail_test", tests, NULL, NULL);
@@ -0,0 +1,286 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <stdio.h>
+
+// Both parsers write a trace of the events they report here, which is
+// then compared.
+struct trace
+{
+	char buf[1024];
+	size_t len;
+};
+
+static void
+trace_append(struct trace *trace, const char *event,
+	     const uint8_t *data, size_t data_len)
+{
+	int written = snprintf(trace->buf + trace->len,
+			       sizeof(trace->buf) - trace->len,
+			       "%s(%.*s) ", event, (int) data_len,
+			       data ? (const char *) data : "");
+	assert_true(written > 0);
+	trace->len += (size_t) written;
+	assert_true(trace->len < sizeof(trace->buf));
+}
+
+static void
+trace_start_message(void *user_data)
+{
+	trace_append(user_data, "start_message", NULL, 0);
+}
+
+static void
+trace_start_tags(void *user_data)
+{
+	trace_append(user_data, "start_tags", NULL, 0);
+}
+
+static void
+trace_on_tag(const uint8_t *name, size_t name_len,
+	     const uint8_t *value, size_t value_len,
+	     void *user_data)
+{
+	trace_append(user_data, "tag", name, name_len);
+	trace_append(user_data, "value", value, value_len);
+}
+
+static void
+trace_end_tags(void *user_data)
+{
+	trace_append(user_data, "end_tags", NULL, 0);
+}
+
+static void
+trace_on_prefix(const uint8_t *prefix, size_t prefix_len, void *user_data)
+{
+	trace_append(user_data, "prefix", prefix, prefix_len);
+}
+
+static void
+trace_on_command(const uint8_t *command, size_t command_len, void *user_data)
+{
+	trace_append(user_data, "command", command, command_len);
+}
+
+static void
+trace_on_command_id(ircmsg_command_id id, void *user_data)
+{
+	char code[16];
+	snprintf(code, sizeof(code), "%d", (int) id);
+	trace_append(user_data, "command_id", (const uint8_t *) code,
+		     strlen(code));
+}
+
+static void
+trace_start_params(void *user_data)
+{
+	trace_append(user_data, "start_params", NULL, 0);
+}
+
+static void
+trace_on_param(const uint8_t *param, size_t param_len, void *user_data)
+{
+	trace_append(user_data, "param", param, param_len);
+}
+
+static void
+trace_end_params(void *user_data)
+{
+	trace_append(user_data, "end_params", NULL, 0);
+}
+
+static void
+trace_end_message(void *user_data)
+{
+	trace_append(user_data, "end_message", NULL, 0);
+}
+
+static void
+trace_on_error(ircmsg_parser_err_code error, void *user_data)
+{
+	char code[16];
+	snprintf(code, sizeof(code), "%d", (int) error);
+	trace_append(user_data, "error", (const uint8_t *) code, strlen(code));
+}
+
+static ircmsg_parser_callbacks trace_cbs = {
+	.start_message = trace_start_message,
+	.start_tags = trace_start_tags,
+	.on_tag = trace_on_tag,
+	.end_tags = trace_end_tags,
+	.on_prefix = trace_on_prefix,
+	.on_command = trace_on_command,
+	.start_params = trace_start_params,
+	.on_param = trace_on_param,
+	.end_params = trace_end_params,
+	.end_message = trace_end_message,
+	.on_error = trace_on_error,
+};
+
+#define IRCMSG_INLINE_PARSER parse_traced
+#define IRCMSG_INLINE_START_MESSAGE trace_start_message
+#define IRCMSG_INLINE_START_TAGS trace_start_tags
+#define IRCMSG_INLINE_ON_TAG trace_on_tag
+#define IRCMSG_INLINE_ON_PREFIX trace_on_prefix
+#define IRCMSG_INLINE_ON_COMMAND trace_on_command
+#define IRCMSG_INLINE_START_PARAMS trace_start_params
+#define IRCMSG_INLINE_ON_PARAM trace_on_param
+#define IRCMSG_INLINE_END_PARAMS trace_end_params
+#define IRCMSG_INLINE_END_MESSAGE trace_end_message
+#define IRCMSG_INLINE_ON_ERROR trace_on_error
+#include <ircmsg/parser_inline.h>
+
+// A second parser in the same file, only interested in commands.
+#define IRCMSG_INLINE_PARSER parse_command_only
+#define IRCMSG_INLINE_ON_COMMAND trace_on_command
+#define IRCMSG_INLINE_ON_COMMAND_ID trace_on_command_id
+#include <ircmsg/parser_inline.h>
+
+static void
+trace_on_tag_section(const uint8_t *tags, size_t tags_len, void *user_data)
+{
+	trace_append(user_data, "tag_section", tags, tags_len);
+}
+
+// And a third one, skipping over the tags.
+#define IRCMSG_INLINE_PARSER parse_lazy_tags
+#define IRCMSG_INLINE_ON_TAG trace_on_tag
+#define IRCMSG_INLINE_ON_TAG_SECTION trace_on_tag_section
+#define IRCMSG_INLINE_ON_COMMAND trace_on_command
+#include <ircmsg/parser_inline.h>
+
+static const ircmsg_parser_limits short_limits = {
+	.max_tags_len = IRCMSG_PARSER_MAX_TAGS_LEN,
+	.max_body_len = 8,
+};
+
+// And a fourth one, with limits of its own.
+#define IRCMSG_INLINE_PARSER parse_short
+#define IRCMSG_INLINE_ON_COMMAND trace_on_command
+#define IRCMSG_INLINE_ON_ERROR trace_on_error
+#define IRCMSG_INLINE_LIMITS (&short_limits)
+#include <ircmsg/parser_inline.h>
+
+static void
+assert_same_as_library(const char *command_str)
+{
+	struct trace library = { .len = 0 };
+	struct trace inlined = { .len = 0 };
+
+	size_t library_consumed = ircmsg_parse((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &trace_cbs,
+					       &library);
+	size_t inlined_consumed = parse_traced((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &inlined);
+
+	assert_int_equal(library_consumed, inlined_consumed);
+	assert_string_equal(library.buf, inlined.buf);
+}
+
+static void
+test_same_as_library (void **state)
+{
+	assert_same_as_library("@foo=bar;baz :nick!user@host PRIVMSG #test :hello there\r\n");
+	assert_same_as_library("PING :server\r\n");
+	assert_same_as_library("PONG server\n");
+	assert_same_as_library(":server 001 nick :Welcome\r\nJOIN #test\r\n");
+	assert_same_as_library("PRIVMSG #test :unterminated");
+	assert_same_as_library("@foo=bar\r\n");
+	assert_same_as_library(":prefix-only\r\n");
+	assert_same_as_library("");
+}
+
+static void
+test_some_callbacks (void **state)
+{
+	const char *command_str = "@foo=bar :nick PRIVMSG #test :hello\r\n";
+	struct trace trace = { .len = 0 };
+
+	size_t consumed = parse_command_only((const uint8_t *) command_str,
+					     strlen(command_str),
+					     &trace);
+
+	assert_int_equal(consumed, strlen(command_str));
+	char expected[64];
+	snprintf(expected, sizeof(expected), "command(PRIVMSG) command_id(%d) ",
+		 (int) IRCMSG_CMD_PRIVMSG);
+	assert_string_equal(trace.buf, expected);
+}
+
+static void
+test_tag_section (void **state)
+{
+	const char *command_str = "@foo=bar;baz :nick PRIVMSG #test :hello\r\n";
+	struct trace trace = { .len = 0 };
+
+	size_t consumed = parse_lazy_tags((const uint8_t *) command_str,
+					  strlen(command_str),
+					  &trace);
+
+	assert_int_equal(consumed, strlen(command_str));
+	assert_string_equal(trace.buf,
+			    "tag_section(foo=bar;baz) command(PRIVMSG) ");
+}
+
+static void
+test_limits (void **state)
+{
+	const char *command_str = "PING :server\r\n";
+	struct trace library = { .len = 0 };
+	struct trace inlined = { .len = 0 };
+
+	size_t library_consumed = ircmsg_parse_ex((const uint8_t *) command_str,
+						  strlen(command_str),
+						  &trace_cbs, &library,
+						  &short_limits);
+	size_t inlined_consumed = parse_short((const uint8_t *) command_str,
+					      strlen(command_str), &inlined);
+
+	assert_int_equal(inlined_consumed, 0);
+	assert_int_equal(library_consumed, inlined_consumed);
+	char expected[64];
+	snprintf(expected, sizeof(expected), "command(PING) error(%d) ",
+		 (int) IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+	assert_string_equal(inlined.buf, expected);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_same_as_library),
+		cmocka_unit_test(test_some_callbacks),
+		cmocka_unit_test(test_tag_section),
+		cmocka_unit_test(test_limits),
+	};
+
+	return cmocka_run_group_tests_name("parse_inline_test", tests, NULL, NULL);
+}
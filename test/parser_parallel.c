@@ -0,0 +1,369 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <ircmsg/parser.h>
+#include <ircmsg/parallel.h>
+
+#define MAX_CHUNKS 8
+
+// Every chunk notes down the commands and params it sees, which
+// concatenated in chunk order must be the same as for a batch.
+struct record
+{
+	char *buf;
+	size_t len;
+	size_t cap;
+	size_t errors;
+};
+
+static void
+record_append(struct record *record, const uint8_t *data, size_t data_len,
+	      char separator)
+{
+	if (record->len + data_len + 1 > record->cap) {
+		record->cap = (record->len + data_len + 1) * 2;
+		record->buf = realloc(record->buf, record->cap);
+		assert_non_null(record->buf);
+	}
+	// A tag without a value has no data at all.
+	if (data_len > 0) memcpy(record->buf + record->len, data, data_len);
+	record->len += data_len;
+	record->buf[record->len++] = separator;
+}
+
+static void
+record_nop(void *user_data)
+{
+}
+
+static void
+record_on_tag(const uint8_t *name, size_t name_len,
+	      const uint8_t *value, size_t value_len,
+	      void *user_data)
+{
+	record_append(user_data, name, name_len, '=');
+}
+
+static void
+record_on_prefix(const uint8_t *prefix, size_t prefix_len, void *user_data)
+{
+	record_append(user_data, prefix, prefix_len, ' ');
+}
+
+static void
+record_on_command(const uint8_t *command, size_t command_len, void *user_data)
+{
+	record_append(user_data, command, command_len, ' ');
+}
+
+static void
+record_on_param(const uint8_t *param, size_t param_len, void *user_data)
+{
+	record_append(user_data, param, param_len, ',');
+}
+
+static void
+record_end_message(void *user_data)
+{
+	record_append(user_data, NULL, 0, '\n');
+}
+
+static void
+record_on_error(ircmsg_parser_err_code error, void *user_data)
+{
+	struct record *record = user_data;
+	++record->errors;
+}
+
+static ircmsg_parser_callbacks record_cbs = {
+	.start_message = record_nop,
+	.start_tags = record_nop,
+	.on_tag = record_on_tag,
+	.end_tags = record_nop,
+	.on_prefix = record_on_prefix,
+	.on_command = record_on_command,
+	.start_params = record_nop,
+	.on_param = record_on_param,
+	.end_params = record_nop,
+	.end_message = record_end_message,
+	.on_error = record_on_error,
+};
+
+static char *
+make_log(size_t message_count, size_t *len)
+{
+	static const char *const terminators[] = { "\r\n", "\n\r", "\n", "\r" };
+
+	size_t cap = message_count * 64;
+	char *log = malloc(cap);
+	assert_non_null(log);
+
+	*len = 0;
+	for (size_t i = 0; i < message_count; ++i) {
+		*len += snprintf(log + *len, cap - *len,
+				 "@id=%zu :nick%zu!u@h PRIVMSG #c%zu :msg %zu%s",
+				 i, i % 7, i % 3, i, terminators[i % 4]);
+	}
+	return log;
+}
+
+static void
+assert_pool_same_as_batch(ircmsg_parallel_pool *pool,
+			  const char *log, size_t log_len, size_t chunk_count)
+{
+	struct record batch = { 0 };
+	size_t batch_consumed = ircmsg_parse_batch((const uint8_t *) log,
+						   log_len, &record_cbs,
+						   &batch);
+
+	struct record records[MAX_CHUNKS] = { { 0 } };
+	void *user_data[MAX_CHUNKS];
+	for (size_t i = 0; i < chunk_count; ++i) user_data[i] = &records[i];
+	ircmsg_parallel_chunk chunks[MAX_CHUNKS];
+
+	size_t consumed;
+	if (pool != NULL) {
+		consumed = ircmsg_parse_parallel_pool(pool,
+						      (const uint8_t *) log,
+						      log_len, &record_cbs,
+						      user_data, chunks,
+						      chunk_count);
+	} else {
+		consumed = ircmsg_parse_parallel((const uint8_t *) log,
+						 log_len, &record_cbs,
+						 user_data, chunks,
+						 chunk_count);
+	}
+	assert_int_equal(consumed, batch_consumed);
+
+	struct record joined = { 0 };
+	size_t next_offset = 0;
+	size_t next_message = 0;
+	for (size_t i = 0; i < chunk_count; ++i) {
+		assert_int_equal(chunks[i].offset, next_offset);
+		assert_int_equal(chunks[i].first_message, next_message);
+		assert_false(chunks[i].failed);
+		assert_int_equal(chunks[i].consumed, chunks[i].len);
+		next_offset += chunks[i].len;
+		next_message += chunks[i].message_count;
+
+		if (records[i].len > 0) {
+			record_append(&joined, (const uint8_t *) records[i].buf,
+				      records[i].len - 1,
+				      records[i].buf[records[i].len - 1]);
+		}
+		free(records[i].buf);
+	}
+
+	assert_int_equal(joined.len, batch.len);
+	assert_true(memcmp(joined.buf, batch.buf, batch.len) == 0);
+	free(joined.buf);
+	free(batch.buf);
+}
+
+static void
+assert_same_as_batch(const char *log, size_t log_len, size_t chunk_count)
+{
+	assert_pool_same_as_batch(NULL, log, log_len, chunk_count);
+}
+
+static void
+test_same_as_batch (void **state)
+{
+	size_t log_len;
+	char *log = make_log(1000, &log_len);
+
+	for (size_t chunk_count = 1; chunk_count <= MAX_CHUNKS; ++chunk_count) {
+		assert_same_as_batch(log, log_len, chunk_count);
+	}
+
+	// Cut off in the middle of the last message.
+	for (size_t chunk_count = 1; chunk_count <= MAX_CHUNKS; ++chunk_count) {
+		assert_same_as_batch(log, log_len - 10, chunk_count);
+	}
+
+	free(log);
+}
+
+static void
+test_more_chunks_than_messages (void **state)
+{
+	const char *log = "PING :a\r\nPING :b\r\n";
+	assert_same_as_batch(log, strlen(log), MAX_CHUNKS);
+}
+
+static void
+test_pool (void **state)
+{
+	size_t log_len;
+	char *log = make_log(1000, &log_len);
+
+	// The same pool parses one buffer after another, split into both
+	// fewer and more chunks than it has threads.
+	ircmsg_parallel_pool pool;
+	assert_true(ircmsg_parallel_pool_init(&pool, 3));
+	for (size_t chunk_count = 1; chunk_count <= MAX_CHUNKS; ++chunk_count) {
+		assert_pool_same_as_batch(&pool, log, log_len, chunk_count);
+		assert_pool_same_as_batch(&pool, log, log_len - 10,
+					  chunk_count);
+	}
+	ircmsg_parallel_pool_destroy(&pool);
+
+	// A pool without threads of its own parses on the calling thread.
+	assert_true(ircmsg_parallel_pool_init(&pool, 0));
+	assert_pool_same_as_batch(&pool, log, log_len, MAX_CHUNKS);
+	ircmsg_parallel_pool_destroy(&pool);
+
+	assert_false(ircmsg_parallel_pool_init(&pool,
+					       IRCMSG_PARALLEL_MAX_THREADS + 1));
+
+	free(log);
+}
+
+static void
+test_terminator_runs (void **state)
+{
+	// The chunks mustn't be split inside a run of terminators, or a
+	// CRCR or LFLF, which the batch rejects, would go unnoticed.
+	const char *const logs[] = {
+		"JOIN #a\n\n",
+		"JOIN #a\n\nPING :b\n",
+		"JOIN #a\r\r\nPING :b\r\n",
+		"JOIN #a\r\n\r\nPING :b\r\n",
+	};
+
+	for (size_t i = 0; i < sizeof(logs) / sizeof(*logs); ++i) {
+		struct record batch = { 0 };
+		size_t batch_consumed =
+			ircmsg_parse_batch((const uint8_t *) logs[i],
+					   strlen(logs[i]), &record_cbs,
+					   &batch);
+		free(batch.buf);
+
+		for (size_t chunk_count = 1;
+		     chunk_count <= MAX_CHUNKS;
+		     ++chunk_count) {
+			struct record records[MAX_CHUNKS] = { { 0 } };
+			void *user_data[MAX_CHUNKS];
+			for (size_t j = 0; j < chunk_count; ++j) {
+				user_data[j] = &records[j];
+			}
+			ircmsg_parallel_chunk chunks[MAX_CHUNKS];
+
+			size_t consumed = ircmsg_parse_parallel(
+				(const uint8_t *) logs[i], strlen(logs[i]),
+				&record_cbs, user_data, chunks, chunk_count);
+			assert_int_equal(consumed, batch_consumed);
+
+			size_t errors = 0;
+			for (size_t j = 0; j < chunk_count; ++j) {
+				errors += records[j].errors;
+				free(records[j].buf);
+			}
+			assert_int_equal(errors, batch.errors);
+		}
+	}
+}
+
+static void
+test_error (void **state)
+{
+	size_t log_len;
+	char *log = make_log(100, &log_len);
+
+	// Turn a message in the middle into one made of tags only.
+	char *bad = strstr(log + log_len / 2, " :nick");
+	assert_non_null(bad);
+	memset(bad, 'x', strcspn(bad, "\r\n"));
+
+	struct record records[4] = { { 0 } };
+	void *user_data[4] = { &records[0], &records[1], &records[2], &records[3] };
+	ircmsg_parallel_chunk chunks[4];
+
+	size_t consumed = ircmsg_parse_parallel((const uint8_t *) log, log_len,
+						&record_cbs, user_data,
+						chunks, 4);
+	assert_int_equal(consumed, ircmsg_parse_batch((const uint8_t *) log,
+						      log_len, &record_cbs,
+						      &records[0]));
+
+	size_t failed = 0;
+	for (size_t i = 0; i < 4; ++i) {
+		if (chunks[i].failed) ++failed;
+		else assert_int_equal(chunks[i].consumed, chunks[i].len);
+		free(records[i].buf);
+	}
+	assert_int_equal(failed, 1);
+	free(log);
+}
+
+static void
+test_limits (void **state)
+{
+	size_t log_len;
+	char *log = make_log(100, &log_len);
+
+	// Every message is longer than this, so each chunk fails on its
+	// first one.
+	const ircmsg_parser_limits limits = {
+		.max_tags_len = IRCMSG_PARSER_MAX_TAGS_LEN,
+		.max_body_len = 16,
+	};
+
+	struct record records[4] = { { 0 } };
+	void *user_data[4] = { &records[0], &records[1], &records[2], &records[3] };
+	ircmsg_parallel_chunk chunks[4];
+
+	size_t consumed = ircmsg_parse_parallel_ex((const uint8_t *) log,
+						   log_len, &record_cbs,
+						   user_data, chunks, 4,
+						   &limits);
+	assert_int_equal(consumed, 0);
+	for (size_t i = 0; i < 4; ++i) {
+		assert_true(chunks[i].failed);
+		assert_int_equal(chunks[i].consumed, 0);
+		assert_int_equal(records[i].errors, 1);
+		free(records[i].buf);
+	}
+	free(log);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_same_as_batch),
+		cmocka_unit_test(test_more_chunks_than_messages),
+		cmocka_unit_test(test_pool),
+		cmocka_unit_test(test_terminator_runs),
+		cmocka_unit_test(test_error),
+		cmocka_unit_test(test_limits),
+	};
+
+	return cmocka_run_group_tests_name("parse_parallel_test", tests, NULL, NULL);
+}
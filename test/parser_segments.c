@@ -0,0 +1,311 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <ircmsg/parser_engine.h>
+#include <stdio.h>
+
+// Each way of parsing writes a trace of the events it reports here,
+// which is then compared.
+struct trace
+{
+	char buf[2048];
+	size_t len;
+	size_t splits;
+};
+
+static void
+trace_append(struct trace *trace, const char *event,
+	     const uint8_t *data, size_t data_len)
+{
+	int written = snprintf(trace->buf + trace->len,
+			       sizeof(trace->buf) - trace->len,
+			       "%s(%.*s) ", event, (int) data_len,
+			       data ? (const char *) data : "");
+	assert_true(written > 0);
+	trace->len += (size_t) written;
+	assert_true(trace->len < sizeof(trace->buf));
+}
+
+static void
+trace_start_message(void *user_data)
+{
+	trace_append(user_data, "start_message", NULL, 0);
+}
+
+static void
+trace_start_tags(void *user_data)
+{
+	trace_append(user_data, "start_tags", NULL, 0);
+}
+
+static void
+trace_on_tag(const uint8_t *name, size_t name_len,
+	     const uint8_t *value, size_t value_len,
+	     void *user_data)
+{
+	trace_append(user_data, "tag", name, name_len);
+	trace_append(user_data, "value", value, value_len);
+}
+
+static void
+trace_end_tags(void *user_data)
+{
+	trace_append(user_data, "end_tags", NULL, 0);
+}
+
+static void
+trace_on_prefix(const uint8_t *prefix, size_t prefix_len, void *user_data)
+{
+	trace_append(user_data, "prefix", prefix, prefix_len);
+}
+
+static void
+trace_on_command(const uint8_t *command, size_t command_len, void *user_data)
+{
+	trace_append(user_data, "command", command, command_len);
+}
+
+static void
+trace_start_params(void *user_data)
+{
+	trace_append(user_data, "start_params", NULL, 0);
+}
+
+static void
+trace_on_param(const uint8_t *param, size_t param_len, void *user_data)
+{
+	trace_append(user_data, "param", param, param_len);
+}
+
+static void
+trace_end_params(void *user_data)
+{
+	trace_append(user_data, "end_params", NULL, 0);
+}
+
+static void
+trace_end_message(void *user_data)
+{
+	trace_append(user_data, "end_message", NULL, 0);
+}
+
+static void
+trace_on_error(ircmsg_parser_err_code err, void *user_data)
+{
+	char code[16];
+	snprintf(code, sizeof(code), "%d", (int) err);
+	trace_append(user_data, "error", (const uint8_t *) code, strlen(code));
+}
+
+static const ircmsg_parser_callbacks trace_callbacks = {
+	.start_message = trace_start_message,
+	.start_tags = trace_start_tags,
+	.on_tag = trace_on_tag,
+	.end_tags = trace_end_tags,
+	.on_prefix = trace_on_prefix,
+	.on_command = trace_on_command,
+	.start_params = trace_start_params,
+	.on_param = trace_on_param,
+	.end_params = trace_end_params,
+	.end_message = trace_end_message,
+	.on_error = trace_on_error,
+};
+
+// Puts the two parts of a split token back together, and reports it
+// like the callbacks would have.
+static void
+trace_on_split_token(ircmsg_split_kind kind,
+		     const uint8_t *first, size_t first_len,
+		     const uint8_t *second, size_t second_len,
+		     void *user_data)
+{
+	struct trace *trace = user_data;
+	++trace->splits;
+
+	uint8_t token[256];
+	assert_true(first_len + second_len <= sizeof(token));
+	memcpy(token, first, first_len);
+	memcpy(token + first_len, second, second_len);
+	size_t len = first_len + second_len;
+
+	switch (kind) {
+	case IRCMSG_SPLIT_TAG: {
+		size_t name_len;
+		const uint8_t *value;
+		size_t value_len;
+		ircmsg_split_tag(token, token + len, &name_len, &value, &value_len);
+		trace_on_tag(token, name_len, value, value_len, user_data);
+		break;
+	}
+	case IRCMSG_SPLIT_PREFIX:
+		trace_on_prefix(token, len, user_data);
+		break;
+	case IRCMSG_SPLIT_COMMAND:
+		trace_on_command(token, len, user_data);
+		break;
+	case IRCMSG_SPLIT_PARAM:
+		trace_on_param(token, len, user_data);
+		break;
+	}
+}
+
+// Splits `buf` at every possible spot, and checks that parsing the
+// two parts as segments gives the same as parsing all of it at once.
+static void
+assert_segments_match_batch(const char *buf)
+{
+	size_t len = strlen(buf);
+
+	struct trace expected = { .len = 0 };
+	size_t expected_consumed =
+		ircmsg_parse_batch((const uint8_t *) buf, len,
+				   &trace_callbacks, &expected);
+
+	for (size_t split = 0; split <= len; ++split) {
+		// Separate allocations, so that reading past the end of
+		// either of them is caught.
+		uint8_t *first = malloc(split + 1);
+		uint8_t *second = malloc(len - split + 1);
+		assert_non_null(first);
+		assert_non_null(second);
+		memcpy(first, buf, split);
+		memcpy(second, buf + split, len - split);
+
+		struct trace actual = { .len = 0 };
+		size_t consumed = ircmsg_parse_segments(first, split,
+							second, len - split,
+							&trace_callbacks,
+							trace_on_split_token,
+							&actual);
+		assert_int_equal(consumed, expected_consumed);
+		assert_string_equal(actual.buf, expected.buf);
+		assert_true(actual.splits <= 1);
+
+		free(first);
+		free(second);
+	}
+}
+
+static void
+test_every_split (void **state)
+{
+	assert_segments_match_batch(
+		"@id=123;time=2019-01-01T00:00:00Z :nick!user@host "
+		"PRIVMSG #channel :hello there\r\n"
+		":irc.example.com 001 nick :Welcome\r\n"
+		"PING :irc.example.com\r\n");
+	assert_segments_match_batch(
+		"@a;b=\\s;c=d=e :p CMD x y z\n\r"
+		"CMD   spaced   out  \r"
+		"CMD :trailing with spaces \n"
+		"CMD incomplete");
+}
+
+static void
+test_split_token (void **state)
+{
+	const char *first = "PING :irc.exa";
+	const char *second = "mple.com\r\n";
+	struct trace trace = { .len = 0 };
+
+	size_t consumed = ircmsg_parse_segments((const uint8_t *) first,
+						strlen(first),
+						(const uint8_t *) second,
+						strlen(second),
+						&trace_callbacks,
+						trace_on_split_token,
+						&trace);
+	assert_int_equal(consumed, strlen(first) + strlen(second));
+	assert_int_equal(trace.splits, 1);
+	assert_string_equal(trace.buf,
+			    "start_message() command(PING) start_params() "
+			    "param(irc.example.com) end_params() end_message() ");
+}
+
+static void
+test_split_terminator (void **state)
+{
+	// The CR at the end of the first segment is only known to be
+	// part of a CRLF once the second one is looked at.
+	assert_segments_match_batch("PING a\r\nPING b\r\n");
+	assert_segments_match_batch("PING a\rPING b\r\n");
+	assert_segments_match_batch("PING a\n\rPING b\n\r");
+
+	// Two of the same terminator in a row are not a valid one.
+	assert_segments_match_batch("PING a\r\rPING b\r\n");
+	assert_segments_match_batch("PING a\n\nPING b\r\n");
+
+	// Nor are they after a whole message, even when the seam falls
+	// right after that message's terminator.
+	assert_segments_match_batch("PING a\r\n\r\rPING b\r\n");
+	assert_segments_match_batch("PING a\r\n\n\nPING b\r\n");
+	assert_segments_match_batch("PING a\r\n\r\r");
+}
+
+static void
+test_incomplete (void **state)
+{
+	const char *first = "PING a\r\nPING";
+	const char *second = " b";
+	struct trace trace = { .len = 0 };
+
+	size_t consumed = ircmsg_parse_segments((const uint8_t *) first,
+						strlen(first),
+						(const uint8_t *) second,
+						strlen(second),
+						&trace_callbacks,
+						trace_on_split_token,
+						&trace);
+	assert_int_equal(consumed, 8);
+	assert_int_equal(trace.splits, 0);
+
+	// A CR at the very end may still be followed by an LF.
+	consumed = ircmsg_parse_segments((const uint8_t *) "PING a", 6,
+					 (const uint8_t *) "\r", 1,
+					 &trace_callbacks,
+					 trace_on_split_token, &trace);
+	assert_int_equal(consumed, 0);
+	consumed = ircmsg_parse_segments((const uint8_t *) "PING a\r", 7,
+					 (const uint8_t *) "", 0,
+					 &trace_callbacks,
+					 trace_on_split_token, &trace);
+	assert_int_equal(consumed, 0);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_every_split),
+		cmocka_unit_test(test_split_token),
+		cmocka_unit_test(test_split_terminator),
+		cmocka_unit_test(test_incomplete),
+	};
+
+	return cmocka_run_group_tests_name("segments_test", tests, NULL, NULL);
+}
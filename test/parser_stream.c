@@ -0,0 +1,256 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <stdio.h>
+#include "parser_test.h"
+
+static int
+stream_setup (void **state)
+{
+	struct irc_test *test_struct = calloc(1, sizeof(*test_struct));
+	if (test_struct == NULL) {
+		return -1;
+	}
+	*state = test_struct;
+	return 0;
+}
+
+static int
+stream_teardown (void **state)
+{
+	struct irc_test *test_struct = *state;
+	free_msg(test_struct->msg);
+	free(test_struct);
+	return 0;
+}
+
+static void
+test_byte_at_a_time (void **state)
+{
+	struct irc_tag tag1 = { .name = "foo", .value = "bar baz" };
+	struct irc_tag *expected_tags_arr[] = {
+		&tag1,
+		NULL,
+	};
+	char *params[] = {
+		"#test",
+		"hello there",
+		NULL,
+	};
+	struct irc_msg expected = {
+		.tags = expected_tags_arr,
+		.prefix = "nick!user@host",
+		.command = "PRIVMSG",
+		.params = params,
+	};
+
+	struct irc_test *test_struct = *state;
+	const char *command_str = "@foo=bar\\sbaz :nick!user@host PRIVMSG #test :hello there\r\n";
+	size_t command_len = strlen(command_str);
+
+	ircmsg_parser_state parser_state;
+	ircmsg_parser_state_init(&parser_state);
+
+	// Everything not yet consumed is passed again with one more
+	// byte appended.
+	size_t start = 0;
+	for (size_t received = 1; received <= command_len; ++received) {
+		size_t consumed =
+			ircmsg_parse_stream(&parser_state,
+					    (const uint8_t *) command_str + start,
+					    received - start,
+					    &test_cbs,
+					    test_struct);
+		start += consumed;
+		assert_false(test_struct->failed);
+		if (received < command_len - 1) {
+			assert_int_equal(start, 0);
+		}
+	}
+	assert_int_equal(start, command_len);
+	assert_true(are_msgs_equal(&expected, test_struct->msg));
+}
+
+static void
+test_split_lfcr (void **state)
+{
+	char *params[] = {
+		"#test",
+		NULL,
+	};
+	struct irc_msg expected = {
+		.tags = NULL,
+		.prefix = NULL,
+		.command = "JOIN",
+		.params = params,
+	};
+
+	struct irc_test *test_struct = *state;
+	const char *first_str = "PING :server\n";
+	const char *second_str = "\rJOIN #test\r\n";
+
+	ircmsg_parser_state parser_state;
+	ircmsg_parser_state_init(&parser_state);
+
+	size_t consumed = ircmsg_parse_stream(&parser_state,
+					      (const uint8_t *) first_str,
+					      strlen(first_str),
+					      &test_cbs,
+					      test_struct);
+	assert_false(test_struct->failed);
+	assert_int_equal(consumed, strlen(first_str));
+
+	free_msg(test_struct->msg);
+	test_struct->msg = NULL;
+
+	// The CR finishes the LFCR of the previous message.
+	consumed = ircmsg_parse_stream(&parser_state,
+				       (const uint8_t *) second_str,
+				       strlen(second_str),
+				       &test_cbs,
+				       test_struct);
+	assert_false(test_struct->failed);
+	assert_int_equal(consumed, strlen(second_str));
+	assert_true(are_msgs_equal(&expected, test_struct->msg));
+}
+
+static void
+test_split_lflf (void **state)
+{
+	struct irc_test *test_struct = *state;
+	const char *first_str = "PING a\n";
+	const char *second_str = "\nPONG b\r\n";
+
+	ircmsg_parser_state parser_state;
+	ircmsg_parser_state_init(&parser_state);
+
+	size_t consumed = ircmsg_parse_stream(&parser_state,
+					      (const uint8_t *) first_str,
+					      strlen(first_str),
+					      &test_cbs,
+					      test_struct);
+	assert_false(test_struct->failed);
+	assert_int_equal(consumed, strlen(first_str));
+
+	// The LF makes an LFLF with the end of the previous message,
+	// rather than starting an empty one.
+	consumed = ircmsg_parse_stream(&parser_state,
+				       (const uint8_t *) second_str,
+				       strlen(second_str),
+				       &test_cbs,
+				       test_struct);
+	assert_int_equal(consumed, 0);
+	assert_true(test_struct->failed);
+	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_INVALID_SENTINEL);
+}
+
+static void
+test_tag_filter (void **state)
+{
+	struct irc_tag tag1 = { .name = "msgid", .value = "abc" };
+	struct irc_tag *expected_tags_arr[] = {
+		&tag1,
+		NULL,
+	};
+	char *params[] = {
+		"#test",
+		NULL,
+	};
+	struct irc_msg expected = {
+		.tags = expected_tags_arr,
+		.prefix = NULL,
+		.command = "JOIN",
+		.params = params,
+	};
+
+	struct irc_test *test_struct = *state;
+	const char *command_str = "@badges=;msgid=abc;color=#fff JOIN #test\r\n";
+
+	const char *const wanted[] = { "msgid" };
+	ircmsg_tag_filter filter;
+	assert_true(ircmsg_tag_filter_init(&filter, wanted, 1));
+
+	ircmsg_parser_state parser_state;
+	ircmsg_parser_state_init(&parser_state);
+	parser_state.tag_filter = &filter;
+
+	size_t consumed = ircmsg_parse_stream(&parser_state,
+					      (const uint8_t *) command_str,
+					      strlen(command_str),
+					      &test_cbs,
+					      test_struct);
+	assert_false(test_struct->failed);
+	assert_int_equal(consumed, strlen(command_str));
+	assert_true(are_msgs_equal(&expected, test_struct->msg));
+}
+
+static void
+test_limits (void **state)
+{
+	struct irc_test *test_struct = *state;
+	const char *command_str = "PRIVMSG #test :hello there";
+
+	ircmsg_parser_state parser_state;
+	ircmsg_parser_state_init(&parser_state);
+	parser_state.limits.max_body_len = 16;
+
+	// The message is given up on as soon as it is too long, without
+	// waiting for the rest of it.
+	size_t consumed = ircmsg_parse_stream(&parser_state,
+					      (const uint8_t *) command_str,
+					      strlen(command_str),
+					      &test_cbs,
+					      test_struct);
+	assert_int_equal(consumed, 0);
+	assert_true(test_struct->failed);
+	assert_int_equal(test_struct->code, IRCMSG_ERR_PARSER_MESSAGE_TOO_LONG);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_byte_at_a_time,
+						stream_setup,
+						stream_teardown),
+		cmocka_unit_test_setup_teardown(test_split_lfcr,
+						stream_setup,
+						stream_teardown),
+		cmocka_unit_test_setup_teardown(test_split_lflf,
+						stream_setup,
+						stream_teardown),
+		cmocka_unit_test_setup_teardown(test_tag_filter,
+						stream_setup,
+						stream_teardown),
+		cmocka_unit_test_setup_teardown(test_limits,
+						stream_setup,
+						stream_teardown),
+	};
+
+	return cmocka_run_group_tests_name("parse_stream_test", tests, NULL, NULL);
+}
@@ -103,6 +103,32 @@ test_all (void **state)
         assert_true(are_msgs_equal(&expected, test_struct->msg));
 }
 
+static void
+test_lone_linefeed (void **state)
+{
+	char *params[] = {
+		"#test",
+		"hello",
+		NULL,
+	};
+	struct irc_msg expected = {
+		.tags = NULL,
+		.prefix = NULL,
+		.command = "PRIVMSG",
+		.params = params,
+	};
+
+	struct irc_test *test_struct = *state;
+        const char *command_str = "PRIVMSG #test :hello\n";
+	size_t consumed = ircmsg_parse((const uint8_t *) command_str,
+				       strlen(command_str),
+				       &test_cbs,
+				       test_struct);
+	assert_false(test_struct->failed);
+        assert_int_equal(consumed, strlen(command_str));
+        assert_true(are_msgs_equal(&expected, test_struct->msg));
+}
+
 int
 main (int argc, char **argv)
 {
@@ -113,6 +139,9 @@ main (int argc, char **argv)
 		cmocka_unit_test_setup_teardown(test_all,
 						success_setup,
 						success_teardown),
+		cmocka_unit_test_setup_teardown(test_lone_linefeed,
+						success_setup,
+						success_teardown),
 	};
 
 	return cmocka_run_group_tests_name("parse_success_test", tests, NULL, NULL);
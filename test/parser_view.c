@@ -0,0 +1,283 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <stdio.h>
+
+static int
+view_setup (void **state)
+{
+	return 0;
+}
+
+static int
+view_teardown (void **state)
+{
+	return 0;
+}
+
+static void
+assert_span_equal(const char *buf, ircmsg_span span, const char *expected)
+{
+	assert_int_equal(span.len, strlen(expected));
+	assert_true(memcmp(buf + span.offset, expected, span.len) == 0);
+}
+
+static void
+test_all (void **state)
+{
+	const char *command_str = "@foo=bar;baz :nick!user@host PRIVMSG #test :hello there\r\n";
+
+	ircmsg_tag_span tags[4];
+	ircmsg_span params[4];
+	ircmsg_message_view view = {
+		.tags = tags,
+		.tags_cap = 4,
+		.params = params,
+		.params_cap = 4,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, strlen(command_str));
+
+	assert_int_equal(view.tag_count, 2);
+	assert_span_equal(command_str, tags[0].name, "foo");
+	assert_span_equal(command_str, tags[0].value, "bar");
+	assert_span_equal(command_str, tags[1].name, "baz");
+	assert_int_equal(tags[1].value.len, 0);
+
+	assert_true(view.has_prefix);
+	assert_span_equal(command_str, view.prefix, "nick!user@host");
+	assert_span_equal(command_str, view.command, "PRIVMSG");
+	assert_int_equal(view.command_id, IRCMSG_CMD_PRIVMSG);
+
+	assert_int_equal(view.param_count, 2);
+	assert_span_equal(command_str, params[0], "#test");
+	assert_span_equal(command_str, params[1], "hello there");
+}
+
+static void
+test_no_prefix (void **state)
+{
+	const char *command_str = "PING :server\r\n";
+
+	ircmsg_span params[1];
+	ircmsg_message_view view = {
+		.tags = NULL,
+		.tags_cap = 0,
+		.params = params,
+		.params_cap = 1,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, strlen(command_str));
+	assert_int_equal(view.tag_count, 0);
+	assert_false(view.has_prefix);
+	assert_span_equal(command_str, view.command, "PING");
+	assert_int_equal(view.command_id, IRCMSG_CMD_PING);
+	assert_int_equal(view.param_count, 1);
+	assert_span_equal(command_str, params[0], "server");
+}
+
+static void
+test_overflow (void **state)
+{
+	const char *command_str = "@a;b;c MODE #test +ov a b\r\n";
+
+	ircmsg_tag_span tags[2];
+	ircmsg_span params[2];
+	ircmsg_message_view view = {
+		.tags = tags,
+		.tags_cap = 2,
+		.params = params,
+		.params_cap = 2,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(view.error, IRCMSG_ERR_PARSER_VIEW_OVERFLOW);
+	assert_int_equal(view.tag_count, 3);
+	assert_int_equal(view.param_count, 4);
+}
+
+static void
+test_error (void **state)
+{
+	const char *command_str = "@foo=bar\r\n";
+
+	ircmsg_message_view view = { 0 };
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, 0);
+	assert_int_equal(view.error, IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE);
+}
+
+static void
+test_lazy_tags (void **state)
+{
+	const char *command_str = "@time=12:00;msgid=abc\\sdef;+draft/reply;a=b=c :nick PRIVMSG #test :hi\r\n";
+
+	ircmsg_span params[2];
+	ircmsg_message_view view = {
+		.params = params,
+		.params_cap = 2,
+		.lazy_tags = true,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, strlen(command_str));
+	assert_int_equal(view.tag_count, 0);
+	assert_span_equal(command_str, view.tag_section,
+			  "time=12:00;msgid=abc\\sdef;+draft/reply;a=b=c");
+	assert_span_equal(command_str, view.prefix, "nick");
+	assert_span_equal(command_str, view.command, "PRIVMSG");
+	assert_int_equal(view.param_count, 2);
+
+	const uint8_t *tags = (const uint8_t *) command_str + view.tag_section.offset;
+	const uint8_t *value;
+	size_t value_len;
+
+	assert_true(ircmsg_tags_find(tags, view.tag_section.len, "msgid",
+				     &value, &value_len));
+	assert_int_equal(value_len, strlen("abc\\sdef"));
+	assert_true(memcmp(value, "abc\\sdef", value_len) == 0);
+
+	assert_true(ircmsg_tags_find(tags, view.tag_section.len, "time",
+				     &value, &value_len));
+	assert_int_equal(value_len, strlen("12:00"));
+	assert_true(memcmp(value, "12:00", value_len) == 0);
+
+	assert_true(ircmsg_tags_find(tags, view.tag_section.len, "+draft/reply",
+				     &value, &value_len));
+	assert_null(value);
+	assert_int_equal(value_len, 0);
+
+	// Same as what on_tag would get.
+	assert_true(ircmsg_tags_find(tags, view.tag_section.len, "a=b",
+				     &value, &value_len));
+	assert_int_equal(value_len, 1);
+
+	assert_false(ircmsg_tags_find(tags, view.tag_section.len, "msg",
+				      &value, &value_len));
+	assert_false(ircmsg_tags_find(tags, view.tag_section.len, "account",
+				      &value, &value_len));
+}
+
+static void
+test_tag_filter (void **state)
+{
+	const char *command_str = "@time=12:00;badges=;msgid=abc;mod=0;msgid2=x;account=a=b;batch :nick PRIVMSG #test :hi\r\n";
+
+	const char *const wanted[] = { "time", "msgid", "batch", "account" };
+	ircmsg_tag_filter filter;
+	assert_true(ircmsg_tag_filter_init(&filter, wanted, 4));
+
+	ircmsg_tag_span tags[4];
+	ircmsg_span params[2];
+	ircmsg_message_view view = {
+		.tags = tags,
+		.tags_cap = 4,
+		.params = params,
+		.params_cap = 2,
+		.tag_filter = &filter,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, strlen(command_str));
+
+	// "account=a=b" is named "account=a" by the parser.
+	assert_int_equal(view.tag_count, 3);
+	assert_span_equal(command_str, tags[0].name, "time");
+	assert_span_equal(command_str, tags[0].value, "12:00");
+	assert_span_equal(command_str, tags[1].name, "msgid");
+	assert_span_equal(command_str, tags[1].value, "abc");
+	assert_span_equal(command_str, tags[2].name, "batch");
+	assert_int_equal(tags[2].value.len, 0);
+	assert_span_equal(command_str, view.command, "PRIVMSG");
+}
+
+static void
+test_tag_filter_init (void **state)
+{
+	const char *const empty[] = { "time", "" };
+	const char *const many[IRCMSG_TAG_FILTER_MAX + 1] = { "a" };
+	const char *const wanted[] = { "msgid" };
+	ircmsg_tag_filter filter;
+	memset(&filter, 0, sizeof(filter));
+	assert_true(ircmsg_tag_filter_init(&filter, wanted, 1));
+
+	// A failure leaves the filter as it was, not half built out of
+	// the names before the bad one.
+	ircmsg_tag_filter before = filter;
+	assert_false(ircmsg_tag_filter_init(&filter, empty, 2));
+	assert_memory_equal(&before, &filter, sizeof(filter));
+	assert_false(ircmsg_tag_filter_init(&filter, many,
+					    IRCMSG_TAG_FILTER_MAX + 1));
+	assert_memory_equal(&before, &filter, sizeof(filter));
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_all,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_no_prefix,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_overflow,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_error,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_lazy_tags,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_tag_filter,
+						view_setup,
+						view_teardown),
+		cmocka_unit_test_setup_teardown(test_tag_filter_init,
+						view_setup,
+						view_teardown),
+	};
+
+	return cmocka_run_group_tests_name("parse_view_test", tests, NULL, NULL);
+}
@@ -0,0 +1,127 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <ircmsg/parser.h>
+
+static void
+assert_part_equal(const char *prefix, ircmsg_span span, const char *expected)
+{
+	assert_int_equal(span.len, strlen(expected));
+	assert_true(memcmp(prefix + span.offset, expected, span.len) == 0);
+}
+
+static ircmsg_prefix_parts
+split(const char *prefix)
+{
+	ircmsg_prefix_parts parts;
+	ircmsg_prefix_split((const uint8_t *) prefix, strlen(prefix), &parts);
+	return parts;
+}
+
+static void
+test_full (void **state)
+{
+	const char *prefix = "nick!~user@host.example.com";
+	ircmsg_prefix_parts parts = split(prefix);
+
+	assert_false(parts.is_server);
+	assert_part_equal(prefix, parts.name, "nick");
+	assert_part_equal(prefix, parts.user, "~user");
+	assert_part_equal(prefix, parts.host, "host.example.com");
+}
+
+static void
+test_partial (void **state)
+{
+	const char *prefix = "nick@host";
+	ircmsg_prefix_parts parts = split(prefix);
+	assert_false(parts.is_server);
+	assert_part_equal(prefix, parts.name, "nick");
+	assert_int_equal(parts.user.len, 0);
+	assert_part_equal(prefix, parts.host, "host");
+
+	prefix = "nick!user";
+	parts = split(prefix);
+	assert_false(parts.is_server);
+	assert_part_equal(prefix, parts.name, "nick");
+	assert_part_equal(prefix, parts.user, "user");
+	assert_int_equal(parts.host.len, 0);
+
+	prefix = "nick";
+	parts = split(prefix);
+	assert_false(parts.is_server);
+	assert_part_equal(prefix, parts.name, "nick");
+	assert_int_equal(parts.user.len, 0);
+	assert_int_equal(parts.host.len, 0);
+}
+
+static void
+test_server (void **state)
+{
+	const char *prefix = "irc.example.com";
+	ircmsg_prefix_parts parts = split(prefix);
+
+	assert_true(parts.is_server);
+	assert_part_equal(prefix, parts.name, "irc.example.com");
+	assert_int_equal(parts.user.len, 0);
+	assert_int_equal(parts.host.len, 0);
+}
+
+static void
+test_view (void **state)
+{
+	const char *command_str = "@a=b :nick!user@host PRIVMSG #test :hi\r\n";
+	ircmsg_tag_span tags[1];
+	ircmsg_span params[2];
+	ircmsg_message_view view = {
+		.tags = tags,
+		.tags_cap = 1,
+		.params = params,
+		.params_cap = 2,
+	};
+
+	size_t consumed = ircmsg_parse_to_view((const uint8_t *) command_str,
+					       strlen(command_str),
+					       &view);
+	assert_int_equal(consumed, strlen(command_str));
+	assert_false(view.prefix_parts.is_server);
+	assert_part_equal(command_str, view.prefix_parts.name, "nick");
+	assert_part_equal(command_str, view.prefix_parts.user, "user");
+	assert_part_equal(command_str, view.prefix_parts.host, "host");
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_full),
+		cmocka_unit_test(test_partial),
+		cmocka_unit_test(test_server),
+		cmocka_unit_test(test_view),
+	};
+
+	return cmocka_run_group_tests_name("prefix_test", tests, NULL, NULL);
+}
@@ -0,0 +1,267 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/serializer.h>
+#include <stdio.h>
+#include "serializer_test.h"
+
+// Wraps the callbacks of serializer_test.c to count how many times
+// they're called, all of them in one counter.
+struct counted_msg
+{
+	struct irc_msg *msg;
+	size_t calls;
+};
+
+static size_t
+counted_tag_count(void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	return serializer_test_cbs.tag_count(counted->msg);
+}
+
+static void
+counted_on_tag(size_t tag_idx,
+	       size_t * const tag_len, const uint8_t **tag,
+	       size_t * const val_len, const uint8_t **val,
+	       void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	serializer_test_cbs.on_tag(tag_idx, tag_len, tag, val_len, val,
+				   counted->msg);
+}
+
+static bool
+counted_on_prefix(size_t * const prefix_len,
+		  const uint8_t **prefix,
+		  void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	return serializer_test_cbs.on_prefix(prefix_len, prefix,
+					     counted->msg);
+}
+
+static void
+counted_on_command(size_t * const command_len,
+		   const uint8_t **command,
+		   void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	serializer_test_cbs.on_command(command_len, command, counted->msg);
+}
+
+static size_t
+counted_param_count(void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	return serializer_test_cbs.param_count(counted->msg);
+}
+
+static void
+counted_on_param(size_t param_idx,
+		 size_t * const param_len,
+		 const uint8_t **param,
+		 void *user_data)
+{
+	struct counted_msg *counted = user_data;
+	++counted->calls;
+	serializer_test_cbs.on_param(param_idx, param_len, param,
+				     counted->msg);
+}
+
+static const ircmsg_serializer_callbacks counted_cbs = {
+	.tag_count = counted_tag_count,
+	.on_tag = counted_on_tag,
+	.on_prefix = counted_on_prefix,
+	.on_command = counted_on_command,
+	.param_count = counted_param_count,
+	.on_param = counted_on_param,
+};
+
+static struct irc_tag tag1 = {
+	.name = "foo",
+	.value = "bar  ",
+};
+static struct irc_tag tag2 = {
+	.name = "baz",
+	.value = NULL,
+};
+static struct irc_tag tag3 = {
+	.name = "time",
+	.value = "a;b\\c\r\n",
+};
+static struct irc_tag *tags[] = {
+	&tag1,
+	&tag2,
+	&tag3,
+	NULL,
+};
+static char *params[] = {
+	"#test",
+	"This is the message",
+	NULL,
+};
+static struct irc_msg msg = {
+	.tags = tags,
+	.prefix = "test!test@example.org",
+	.command = "PRIVMSG",
+	.params = params,
+};
+
+static const char *expected =
+	"@foo=bar\\s\\s;baz;time=a\\:b\\\\c\\r\\n "
+	":test!test@example.org PRIVMSG #test :This is the message\r\n";
+
+static int
+serializer_checked_setup (void **state)
+{
+	return 0;
+}
+
+static int
+serializer_checked_teardown (void **state)
+{
+	return 0;
+}
+
+static void
+test_fits (void **state)
+{
+	size_t expected_length = strlen(expected);
+	uint8_t buf[256];
+	memset(buf, 0, sizeof(buf));
+	bool truncated = true;
+	size_t serialized_length =
+		ircmsg_serialize_checked(buf, sizeof(buf),
+					 &serializer_test_cbs, &msg,
+					 &truncated);
+
+	assert_false(truncated);
+	assert_int_equal(expected_length, serialized_length);
+	assert_string_equal(expected, buf);
+	assert_int_equal(serialized_length,
+			 ircmsg_serialize_buffer_len(&serializer_test_cbs,
+						     &msg));
+}
+
+static void
+test_fits_exactly (void **state)
+{
+	size_t expected_length = strlen(expected);
+	uint8_t *buf = calloc(expected_length + 1, sizeof(*buf));
+	bool truncated = true;
+	size_t serialized_length =
+		ircmsg_serialize_checked(buf, expected_length,
+					 &serializer_test_cbs, &msg,
+					 &truncated);
+
+	assert_false(truncated);
+	assert_int_equal(expected_length, serialized_length);
+	assert_string_equal(expected, buf);
+
+	free(buf);
+}
+
+static void
+test_too_small (void **state)
+{
+	size_t expected_length = strlen(expected);
+	uint8_t *buf = calloc(expected_length + 1, sizeof(*buf));
+
+	// Whatever the buffer is short of, the size needed is the same,
+	// and nothing is written past the end of the buffer.
+	for (size_t buf_size = 0; buf_size < expected_length; ++buf_size) {
+		memset(buf, 0, expected_length + 1);
+		bool truncated = false;
+		size_t serialized_length =
+			ircmsg_serialize_checked(buf, buf_size,
+						 &serializer_test_cbs, &msg,
+						 &truncated);
+
+		assert_true(truncated);
+		assert_int_equal(expected_length, serialized_length);
+		for (size_t i = buf_size; i <= expected_length; ++i) {
+			assert_int_equal(0, buf[i]);
+		}
+		// What was written is where it belongs.
+		assert_memory_equal(expected, buf, strlen((char *) buf));
+	}
+
+	free(buf);
+}
+
+static void
+test_calls_once (void **state)
+{
+	uint8_t buf[256];
+	struct counted_msg counted = {
+		.msg = &msg,
+		.calls = 0,
+	};
+	bool truncated = true;
+
+	// tag_count, three on_tag, on_prefix, on_command, param_count and
+	// two on_param.
+	const size_t expected_calls = 9;
+
+	ircmsg_serialize_checked(buf, sizeof(buf), &counted_cbs, &counted,
+				 &truncated);
+	assert_false(truncated);
+	assert_int_equal(expected_calls, counted.calls);
+
+	counted.calls = 0;
+	ircmsg_serialize_checked(buf, 10, &counted_cbs, &counted,
+				 &truncated);
+	assert_true(truncated);
+	assert_int_equal(expected_calls, counted.calls);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_fits,
+						serializer_checked_setup,
+						serializer_checked_teardown),
+		cmocka_unit_test_setup_teardown(test_fits_exactly,
+						serializer_checked_setup,
+						serializer_checked_teardown),
+		cmocka_unit_test_setup_teardown(test_too_small,
+						serializer_checked_setup,
+						serializer_checked_teardown),
+		cmocka_unit_test_setup_teardown(test_calls_once,
+						serializer_checked_setup,
+						serializer_checked_teardown),
+	};
+
+	return cmocka_run_group_tests_name("serialize_checked_test", tests, NULL, NULL);
+}
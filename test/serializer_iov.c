@@ -0,0 +1,238 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/serializer_iov.h>
+#include <stdio.h>
+#include "serializer_test.h"
+
+static struct irc_tag tag1 = {
+	.name = "foo",
+	.value = "bar  ",
+};
+static struct irc_tag tag2 = {
+	.name = "baz",
+	.value = NULL,
+};
+static struct irc_tag *tags[] = {
+	&tag1,
+	&tag2,
+	NULL,
+};
+static char *params[] = {
+	"#test",
+	"This is a message long enough not to be copied around",
+	NULL,
+};
+static struct irc_msg msg = {
+	.tags = tags,
+	.prefix = "test!test@example.org",
+	.command = "PRIVMSG",
+	.params = params,
+};
+
+static const char *expected =
+	"@foo=bar\\s\\s;baz :test!test@example.org PRIVMSG #test "
+	":This is a message long enough not to be copied around\r\n";
+
+// The length of "@foo=bar\\s\\s;baz ".
+static const size_t tags_len = 17;
+
+static size_t
+gather(const struct iovec *iov, size_t iov_count, char *out)
+{
+	size_t len = 0;
+	for (size_t i = 0; i < iov_count; ++i) {
+		memcpy(out + len, iov[i].iov_base, iov[i].iov_len);
+		len += iov[i].iov_len;
+	}
+	out[len] = '\0';
+	return len;
+}
+
+static int
+serializer_iov_setup (void **state)
+{
+	return 0;
+}
+
+static int
+serializer_iov_teardown (void **state)
+{
+	return 0;
+}
+
+static void
+test_all (void **state)
+{
+	struct iovec iov[IRCMSG_SERIALIZE_IOV_MAX(2)];
+	uint8_t scratch[256];
+	char out[256];
+	size_t msg_len = 0;
+	size_t iov_count =
+		ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(2),
+				     scratch, sizeof(scratch),
+				     &serializer_test_cbs, &msg, &msg_len);
+
+	assert_int_not_equal(0, iov_count);
+	assert_int_equal(strlen(expected), msg_len);
+	assert_int_equal(msg_len, gather(iov, iov_count, out));
+	assert_string_equal(expected, out);
+
+	// Everything up to the long param is short enough to be copied,
+	// and the param itself is referenced in place.
+	assert_int_equal(3, iov_count);
+	assert_ptr_equal(params[1], iov[1].iov_base);
+	assert_int_equal(strlen(params[1]), iov[1].iov_len);
+}
+
+static void
+test_simple (void **state)
+{
+	char *ping_params[] = {
+		"irc.example.org",
+		NULL,
+	};
+	struct irc_msg ping = {
+		.tags = NULL,
+		.prefix = NULL,
+		.command = "PING",
+		.params = ping_params,
+	};
+	struct irc_msg motd = {
+		.tags = NULL,
+		.prefix = NULL,
+		.command = "MOTD",
+		.params = NULL,
+	};
+	struct iovec iov[IRCMSG_SERIALIZE_IOV_MAX(1)];
+	uint8_t scratch[64];
+	char out[64];
+	size_t msg_len = 0;
+
+	size_t iov_count =
+		ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(1),
+				     scratch, sizeof(scratch),
+				     &serializer_test_cbs, &ping, &msg_len);
+	assert_int_equal(1, iov_count);
+	assert_int_equal(msg_len, gather(iov, iov_count, out));
+	assert_string_equal("PING :irc.example.org\r\n", out);
+
+	iov_count =
+		ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(0),
+				     scratch, sizeof(scratch),
+				     &serializer_test_cbs, &motd, &msg_len);
+	assert_int_equal(1, iov_count);
+	assert_int_equal(msg_len, gather(iov, iov_count, out));
+	assert_string_equal("MOTD\r\n", out);
+}
+
+static void
+test_scratch_size (void **state)
+{
+	struct iovec iov[IRCMSG_SERIALIZE_IOV_MAX(2)];
+	uint8_t scratch[256];
+	char out[256];
+
+	// The scratch space the message needs at least. With less than
+	// the tags and separators take, it fails; with a bit more, short
+	// pieces start getting copied instead of referenced.
+	const size_t min_scratch = tags_len + 2 + 5;
+	for (size_t scratch_size = 0;
+	     scratch_size <= sizeof(scratch);
+	     ++scratch_size) {
+		size_t msg_len = 0;
+		size_t iov_count =
+			ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(2),
+					     scratch, scratch_size,
+					     &serializer_test_cbs, &msg,
+					     &msg_len);
+		if (scratch_size < min_scratch) {
+			assert_int_equal(0, iov_count);
+			assert_int_equal(0, msg_len);
+			continue;
+		}
+
+		assert_int_not_equal(0, iov_count);
+		assert_true(iov_count <= IRCMSG_SERIALIZE_IOV_MAX(2));
+		assert_int_equal(strlen(expected), msg_len);
+		assert_int_equal(msg_len, gather(iov, iov_count, out));
+		assert_string_equal(expected, out);
+	}
+}
+
+static void
+test_iov_cap (void **state)
+{
+	struct iovec iov[IRCMSG_SERIALIZE_IOV_MAX(2)];
+	uint8_t scratch[256];
+	char out[256];
+	size_t msg_len = 0;
+
+	// With just enough scratch space for the separators, every piece
+	// of the message gets an iovec of its own.
+	const size_t min_scratch = tags_len + 2 + 5;
+	size_t iov_count =
+		ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(2),
+				     scratch, min_scratch,
+				     &serializer_test_cbs, &msg, &msg_len);
+	assert_int_equal(IRCMSG_SERIALIZE_IOV_MAX(2), iov_count);
+	assert_int_equal(msg_len, gather(iov, iov_count, out));
+	assert_string_equal(expected, out);
+
+	iov_count =
+		ircmsg_serialize_iov(iov, IRCMSG_SERIALIZE_IOV_MAX(2) - 1,
+				     scratch, min_scratch,
+				     &serializer_test_cbs, &msg, &msg_len);
+	assert_int_equal(0, iov_count);
+
+	iov_count =
+		ircmsg_serialize_iov(iov, 2,
+				     scratch, sizeof(scratch),
+				     &serializer_test_cbs, &msg, &msg_len);
+	assert_int_equal(0, iov_count);
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test_setup_teardown(test_all,
+						serializer_iov_setup,
+						serializer_iov_teardown),
+		cmocka_unit_test_setup_teardown(test_simple,
+						serializer_iov_setup,
+						serializer_iov_teardown),
+		cmocka_unit_test_setup_teardown(test_scratch_size,
+						serializer_iov_setup,
+						serializer_iov_teardown),
+		cmocka_unit_test_setup_teardown(test_iov_cap,
+						serializer_iov_setup,
+						serializer_iov_teardown),
+	};
+
+	return cmocka_run_group_tests_name("serialize_iov_test", tests, NULL, NULL);
+}
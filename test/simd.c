@@ -0,0 +1,252 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <ircmsg/parser.h>
+#include <ircmsg/simd.h>
+
+// The level picked when the library was loaded, before any test
+// changes it.
+static ircmsg_simd_level loaded_level;
+
+// Everything the parser reports, folded into one hash.
+struct trace
+{
+	const uint8_t *buf;
+	uint64_t hash;
+};
+
+static void
+trace_mix(struct trace *trace, uint64_t value)
+{
+	trace->hash = (trace->hash ^ value) * UINT64_C(0x100000001b3);
+}
+
+static void
+trace_span(struct trace *trace, int event, const uint8_t *span, size_t len)
+{
+	trace_mix(trace, event);
+	trace_mix(trace, span == NULL ? SIZE_MAX : (size_t) (span - trace->buf));
+	trace_mix(trace, len);
+}
+
+static void
+on_event(void *user_data)
+{
+	trace_mix(user_data, 1);
+}
+
+static void
+on_tag(const uint8_t *name, size_t name_len,
+       const uint8_t *value, size_t value_len,
+       void *user_data)
+{
+	trace_span(user_data, 2, name, name_len);
+	trace_span(user_data, 3, value, value_len);
+}
+
+static void
+on_token(const uint8_t *token, size_t token_len, void *user_data)
+{
+	trace_span(user_data, 4, token, token_len);
+}
+
+static void
+on_error(ircmsg_parser_err_code error, void *user_data)
+{
+	trace_mix(user_data, 5 + error);
+}
+
+static const ircmsg_parser_callbacks trace_cbs = {
+	.start_message = on_event,
+	.start_tags = on_event,
+	.on_tag = on_tag,
+	.end_tags = on_event,
+	.on_prefix = on_token,
+	.on_command = on_token,
+	.start_params = on_event,
+	.on_param = on_token,
+	.end_params = on_event,
+	.end_message = on_event,
+	.on_error = on_error,
+};
+
+// What each of the scanning functions makes of one input.
+struct results
+{
+	uint64_t parse_hash;
+	size_t consumed;
+	size_t frame_count;
+	size_t frame_ends[64];
+	bool invalid;
+	size_t unescaped_size;
+	uint8_t unescaped[512];
+};
+
+static void
+run_all(const uint8_t *buf, size_t len, struct results *results)
+{
+	memset(results, 0, sizeof(*results));
+
+	struct trace trace = { .buf = buf, .hash = UINT64_C(0xcbf29ce484222325) };
+	results->consumed = ircmsg_parse(buf, len, &trace_cbs, &trace);
+	results->parse_hash = trace.hash;
+
+	results->frame_count = ircmsg_find_frames(buf, len,
+						  results->frame_ends, 64,
+						  &results->invalid);
+
+	results->unescaped_size = ircmsg_tag_value_unescaped_size(buf, len);
+	ircmsg_tag_value_unescape(buf, len, results->unescaped,
+				  sizeof(results->unescaped));
+}
+
+static uint32_t
+next_random(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return *seed >> 16;
+}
+
+static void
+test_names (void **state)
+{
+	assert_string_equal(ircmsg_simd_level_name(IRCMSG_SIMD_SCALAR), "scalar");
+	assert_string_equal(ircmsg_simd_level_name(IRCMSG_SIMD_AVX512), "avx512");
+	assert_null(ircmsg_simd_level_name(IRCMSG_SIMD_AVX512 + 1));
+}
+
+static void
+test_set_level (void **state)
+{
+	ircmsg_simd_level level = ircmsg_simd_get_level();
+	assert_true(ircmsg_simd_set_level(level));
+	assert_false(ircmsg_simd_set_level(IRCMSG_SIMD_AVX512 + 1));
+	assert_int_equal(ircmsg_simd_get_level(), level);
+}
+
+static void
+test_forced_level (void **state)
+{
+	// Only meaningful when the tests are run with IRCMSG_SIMD set to
+	// a level this CPU supports, as the CI does for each of them.
+	const char *forced = getenv("IRCMSG_SIMD");
+	if (forced == NULL) return;
+	for (int level = IRCMSG_SIMD_SCALAR; level <= IRCMSG_SIMD_AVX512; ++level) {
+		if (strcmp(forced, ircmsg_simd_level_name(level)) != 0) continue;
+		if (ircmsg_simd_set_level(level)) {
+			assert_int_equal(loaded_level, level);
+		}
+	}
+	ircmsg_simd_set_level(loaded_level);
+}
+
+static void
+test_levels_agree (void **state)
+{
+	// Mostly bytes the scans skip over, so that runs of them are
+	// long enough to take up several vectors.
+	static const char interesting[] = " :@;=\r\n\\sn";
+	uint32_t seed = 1;
+	uint8_t buf[300];
+	struct results expected;
+	struct results actual;
+
+	for (int i = 0; i < 20000; ++i) {
+		size_t len = next_random(&seed) % sizeof(buf);
+		for (size_t j = 0; j < len; ++j) {
+			buf[j] = next_random(&seed) % 16 == 0 ?
+				(uint8_t) interesting[next_random(&seed) % (sizeof(interesting) - 1)] :
+				(uint8_t) ('a' + next_random(&seed) % 26);
+		}
+
+		// Without run time dispatch, there is only the one level.
+		ircmsg_simd_set_level(IRCMSG_SIMD_SCALAR);
+		run_all(buf, len, &expected);
+		for (int level = IRCMSG_SIMD_SSE2; level <= IRCMSG_SIMD_AVX512; ++level) {
+			if (!ircmsg_simd_set_level(level)) continue;
+			run_all(buf, len, &actual);
+			assert_memory_equal(&actual, &expected, sizeof(expected));
+		}
+	}
+	ircmsg_simd_set_level(loaded_level);
+}
+
+// Flips through every level the CPU supports until told to stop.
+static void *
+switch_levels(void *arg)
+{
+	bool *stop = arg;
+	while (!__atomic_load_n(stop, __ATOMIC_RELAXED)) {
+		for (int level = IRCMSG_SIMD_SCALAR; level <= IRCMSG_SIMD_AVX512; ++level) {
+			ircmsg_simd_set_level(level);
+		}
+	}
+	return NULL;
+}
+
+static void
+test_switch_while_parsing (void **state)
+{
+	static const char input[] =
+		"@time=2019-01-01T00:00:00.000Z;msgid=abcdefghijklmnopqrstuvwxyz "
+		":nickname!username@some.long.host.name.example.org "
+		"PRIVMSG #channel :a trailing parameter long enough for a few vectors\r\n";
+	const uint8_t *buf = (const uint8_t *) input;
+	size_t len = sizeof(input) - 1;
+
+	struct results expected;
+	struct results actual;
+	run_all(buf, len, &expected);
+
+	bool stop = false;
+	pthread_t switcher;
+	assert_int_equal(pthread_create(&switcher, NULL, switch_levels, &stop), 0);
+	for (int i = 0; i < 20000; ++i) {
+		run_all(buf, len, &actual);
+		assert_memory_equal(&actual, &expected, sizeof(expected));
+	}
+	__atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+	pthread_join(switcher, NULL);
+	ircmsg_simd_set_level(loaded_level);
+}
+
+int
+main (int argc, char **argv)
+{
+	loaded_level = ircmsg_simd_get_level();
+
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_names),
+		cmocka_unit_test(test_set_level),
+		cmocka_unit_test(test_forced_level),
+		cmocka_unit_test(test_levels_agree),
+		cmocka_unit_test(test_switch_while_parsing),
+	};
+
+	return cmocka_run_group_tests_name("simd_test", tests, NULL, NULL);
+}
@@ -0,0 +1,178 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ircmsg/parser.h>
+#include <ircmsg/serializer.h>
+#include <ircmsg/stats.h>
+#include "serializer_test.h"
+
+static void
+ignore_event(void *user_data)
+{
+}
+
+static void
+ignore_tag(const uint8_t *name, size_t name_len,
+	   const uint8_t *value, size_t value_len,
+	   void *user_data)
+{
+}
+
+static void
+ignore_token(const uint8_t *token, size_t token_len, void *user_data)
+{
+}
+
+static void
+ignore_error(ircmsg_parser_err_code error, void *user_data)
+{
+}
+
+static const ircmsg_parser_callbacks ignore_cbs = {
+	.start_message = ignore_event,
+	.start_tags = ignore_event,
+	.on_tag = ignore_tag,
+	.end_tags = ignore_event,
+	.on_prefix = ignore_token,
+	.on_command = ignore_token,
+	.start_params = ignore_event,
+	.on_param = ignore_token,
+	.end_params = ignore_event,
+	.end_message = ignore_event,
+	.on_error = ignore_error,
+};
+
+static int
+stats_setup (void **state)
+{
+	ircmsg_stats_reset();
+	return 0;
+}
+
+static int
+stats_teardown (void **state)
+{
+	ircmsg_stats_reset();
+	return 0;
+}
+
+static void
+test_buckets (void **state)
+{
+	assert_int_equal(ircmsg_stats_count_bucket(0), 0);
+	assert_int_equal(ircmsg_stats_count_bucket(15), 15);
+	assert_int_equal(ircmsg_stats_count_bucket(1000),
+			 IRCMSG_STATS_COUNT_BUCKETS - 1);
+
+	assert_int_equal(ircmsg_stats_length_bucket(0), 0);
+	assert_int_equal(ircmsg_stats_length_bucket(1), 1);
+	assert_int_equal(ircmsg_stats_length_bucket(2), 2);
+	assert_int_equal(ircmsg_stats_length_bucket(3), 2);
+	assert_int_equal(ircmsg_stats_length_bucket(512), 10);
+	assert_int_equal(ircmsg_stats_length_bucket(SIZE_MAX),
+			 IRCMSG_STATS_LENGTH_BUCKETS - 1);
+}
+
+static void
+test_parse_counts (void **state)
+{
+	const char *batch_str =
+		"@a=b;cd :nick!user@host PRIVMSG #chan :hello there\r\n"
+		"PING\r\n"
+		"@foo\r\n";
+	size_t consumed = ircmsg_parse_batch_recover((const uint8_t *) batch_str,
+						     strlen(batch_str),
+						     &ignore_cbs,
+						     NULL,
+						     NULL);
+	assert_int_equal(consumed, strlen(batch_str));
+
+	ircmsg_stats stats;
+	if (!ircmsg_stats_snapshot(&stats)) {
+		// Built without the counters, which must then stay at 0.
+		ircmsg_stats zero;
+		memset(&zero, 0, sizeof(zero));
+		assert_memory_equal(&stats, &zero, sizeof(stats));
+		return;
+	}
+
+	assert_int_equal(stats.messages, 2);
+	assert_int_equal(stats.bytes, strlen("@a=b;cd :nick!user@host PRIVMSG #chan :hello there\r\n") +
+			 strlen("PING\r\n"));
+	assert_int_equal(stats.errors[IRCMSG_ERR_PARSER_UNEXPECTED_END_OF_MESSAGE], 1);
+	assert_int_equal(stats.tags_per_message[0], 1);
+	assert_int_equal(stats.tags_per_message[2], 1);
+	assert_int_equal(stats.params_per_message[0], 1);
+	assert_int_equal(stats.params_per_message[2], 1);
+	// "ab" and "cd"
+	assert_int_equal(stats.tag_lengths[ircmsg_stats_length_bucket(2)], 2);
+	// "#chan" and "hello there"
+	assert_int_equal(stats.param_lengths[ircmsg_stats_length_bucket(5)], 1);
+	assert_int_equal(stats.param_lengths[ircmsg_stats_length_bucket(11)], 1);
+
+	ircmsg_stats_reset();
+	assert_true(ircmsg_stats_snapshot(&stats));
+	assert_int_equal(stats.messages, 0);
+}
+
+static void
+test_serialize_counts (void **state)
+{
+	char *params[] = { "#chan", "hi", NULL };
+	struct irc_tag *tags[] = { NULL };
+	struct irc_msg msg = {
+		.tags = tags,
+		.prefix = NULL,
+		.command = "PRIVMSG",
+		.params = params,
+	};
+
+	uint8_t buf[64];
+	ircmsg_serialize(buf, sizeof(buf), &serializer_test_cbs, &msg);
+
+	ircmsg_stats stats;
+	if (!ircmsg_stats_snapshot(&stats)) return;
+
+	assert_int_equal(stats.serialized_messages, 1);
+	assert_int_equal(stats.serialized_bytes, strlen("PRIVMSG #chan :hi\r\n"));
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_buckets),
+		cmocka_unit_test_setup_teardown(test_parse_counts,
+						stats_setup,
+						stats_teardown),
+		cmocka_unit_test_setup_teardown(test_serialize_counts,
+						stats_setup,
+						stats_teardown),
+	};
+
+	return cmocka_run_group_tests_name("stats_test", tests, NULL, NULL);
+}
@@ -0,0 +1,105 @@
+// Copyright (c) 2019 Jani Juhani Sinervo
+//
+//  Permission is hereby granted, free of charge, to any person obtaining a
+//  copy of this software and associated documentation files (the "Software"),
+//  to deal in the Software without restriction, including without limitation
+//  the rights to use, copy, modify, merge, publish, distribute, sublicense,
+//  and/or sell copies of the Software, and to permit persons to whom the
+//  Software is furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be included in
+//  all copies or substantial portions of the Software.
+//
+//  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//  OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+//  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//  FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+//  DEALINGS IN THE SOFTWARE.
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <string.h>
+#include <ircmsg/parser.h>
+
+struct unescape_case
+{
+	const char *escaped;
+	const char *unescaped;
+};
+
+static const struct unescape_case cases[] = {
+	{ "", "" },
+	{ "plain", "plain" },
+	{ "a\\sb", "a b" },
+	{ "\\:\\s\\\\\\r\\n", "; \\\r\n" },
+	{ "\\x", "x" },
+	{ "trailing\\", "trailing" },
+	{ "\\", "" },
+	{ "{\"a\":\"a long payload that spans more than one vector\\sof\\sbytes\"}",
+	  "{\"a\":\"a long payload that spans more than one vector of bytes\"}" },
+	{ "0123456789abcdef0123456789abcdef\\s0123456789abcdef0123456789abcdef\\",
+	  "0123456789abcdef0123456789abcdef 0123456789abcdef0123456789abcdef" },
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static void
+test_into (void **state)
+{
+	for (size_t i = 0; i < CASE_COUNT; ++i) {
+		const char *escaped = cases[i].escaped;
+		uint8_t buf[128];
+		size_t len = ircmsg_tag_value_unescape_into((const uint8_t *) escaped,
+							    strlen(escaped),
+							    buf, sizeof(buf));
+		assert_int_equal(len, strlen(cases[i].unescaped));
+		assert_true(memcmp(buf, cases[i].unescaped, len) == 0);
+		assert_int_equal(ircmsg_tag_value_unescaped_size((const uint8_t *) escaped,
+								 strlen(escaped)),
+				 len);
+	}
+}
+
+static void
+test_into_short_buffer (void **state)
+{
+	const char *escaped = "abc\\sdef";
+	uint8_t buf[8];
+	memset(buf, 'X', sizeof(buf));
+
+	size_t len = ircmsg_tag_value_unescape_into((const uint8_t *) escaped,
+						    strlen(escaped), buf, 4);
+	assert_int_equal(len, 7);
+	assert_true(memcmp(buf, "abc XXXX", 8) == 0);
+}
+
+static void
+test_in_place (void **state)
+{
+	for (size_t i = 0; i < CASE_COUNT; ++i) {
+		uint8_t buf[128];
+		size_t escaped_len = strlen(cases[i].escaped);
+		memcpy(buf, cases[i].escaped, escaped_len);
+
+		size_t len = ircmsg_tag_value_unescape_in_place(buf, escaped_len);
+		assert_int_equal(len, strlen(cases[i].unescaped));
+		assert_true(memcmp(buf, cases[i].unescaped, len) == 0);
+	}
+}
+
+int
+main (int argc, char **argv)
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(test_into),
+		cmocka_unit_test(test_into_short_buffer),
+		cmocka_unit_test(test_in_place),
+	};
+
+	return cmocka_run_group_tests_name("unescape_test", tests, NULL, NULL);
+}